@@ -0,0 +1,225 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_fields.h"
+
+#if (CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN > 0)
+
+static const char *TAG = "config_cmd";
+
+#define CFG_CMD_QUEUE_MASK (CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN - 1)
+#define CFG_CMD_STR_MAX 32
+_Static_assert((CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN & CFG_CMD_QUEUE_MASK) == 0, "command queue length must be a power of two");
+
+typedef enum {
+    CFG_CMD_SET_NUM,
+    CFG_CMD_SET_STR,
+    CFG_CMD_STEP,
+} config_cmd_op_t;
+
+// seq tells who may touch the slot: pos when free for the producer at pos, pos + 1 when filled
+typedef struct config_cmd_s {
+    atomic_uint seq;
+    uint8_t op;   // config_cmd_op_t
+    uint8_t item; // config_item_t
+    union {
+        double num;
+        char str[CFG_CMD_STR_MAX];
+    };
+} config_cmd_t;
+
+static config_cmd_t config_cmd_queue[CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN];
+static atomic_uint config_cmd_head = 0; // next slot for producers
+static unsigned config_cmd_tail = 0;    // next slot for the owner task, only it touches this
+static _Atomic(TaskHandle_t) config_cmd_task_handle = 0; // cleared by the task itself when it stops
+static atomic_bool config_cmd_stopping = 0;
+static logger_config_t *config_cmd_config = 0;
+static uint8_t config_cmd_ublox_hw = 0;
+static config_txn_t config_cmd_txn; // owner task only
+
+/// bounded multi producer queue, producers never wait, only the owner task consumes
+static esp_err_t config_cmd_push(const config_cmd_t *cmd) {
+    unsigned pos = atomic_load_explicit(&config_cmd_head, memory_order_relaxed);
+    config_cmd_t *slot;
+    for (;;) {
+        slot = &config_cmd_queue[pos & CFG_CMD_QUEUE_MASK];
+        int dif = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&config_cmd_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return ESP_ERR_NO_MEM; // owner task is a full queue behind
+        } else {
+            pos = atomic_load_explicit(&config_cmd_head, memory_order_relaxed);
+        }
+    }
+    slot->op = cmd->op;
+    slot->item = cmd->item;
+    memcpy(slot->str, cmd->str, sizeof(slot->str));
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    TaskHandle_t task = atomic_load(&config_cmd_task_handle);
+    if (task)
+        xTaskNotifyGive(task);
+    return ESP_OK;
+}
+
+static int config_cmd_pop(config_cmd_t *cmd) {
+    config_cmd_t *slot = &config_cmd_queue[config_cmd_tail & CFG_CMD_QUEUE_MASK];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != config_cmd_tail + 1)
+        return 0;
+    cmd->op = slot->op;
+    cmd->item = slot->item;
+    memcpy(cmd->str, slot->str, sizeof(cmd->str));
+    atomic_store_explicit(&slot->seq, config_cmd_tail + CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN, memory_order_release);
+    config_cmd_tail++;
+    return 1;
+}
+
+/// one command into the staged copy, a value outside the item range drops only this command
+static void config_cmd_apply(config_txn_t *txn, const config_cmd_t *cmd) {
+    const config_field_t *f = &config_fields[cmd->item];
+    uint8_t prev[UINT8_MAX]; // value staged by earlier commands, put back when this one is dropped
+    memcpy(prev, CFG_FIELD_PTR(f, &txn->staged), f->size);
+    int changed = 0;
+    switch (cmd->op) {
+    case CFG_CMD_SET_NUM:
+        if (!config_field_in_range(f, cmd->num)) {
+            ESP_LOGW(TAG, "[%s] %s out of range", __func__, f->name);
+            return;
+        }
+        changed = config_field_set_num(f, &txn->staged, cmd->num, 0);
+        break;
+    case CFG_CMD_SET_STR:
+        changed = config_field_set_str(f, &txn->staged, cmd->str, strnlen(cmd->str, sizeof(cmd->str)), 0);
+        break;
+    case CFG_CMD_STEP:
+        config_field_step(f, &txn->staged);
+        changed = 1;
+        break;
+    }
+    if (!changed)
+        return;
+    if (config_txn_check(txn, 1ULL << cmd->item) >= 0) {
+        // checked here and not at commit, so the rest of the batch still goes out
+        memcpy(CFG_FIELD_PTR(f, &txn->staged), prev, f->size);
+        ESP_LOGW(TAG, "[%s] %s out of range, dropped", __func__, f->name);
+        return;
+    }
+    txn->changed |= 1ULL << cmd->item;
+}
+
+/// everything queued so far goes out as one transaction, one save and one publish
+static void config_cmd_drain(void) {
+    config_cmd_t cmd;
+    if (!config_cmd_pop(&cmd))
+        return;
+    int64_t start = config_metric_start();
+    config_txn_begin(&config_cmd_txn, config_cmd_config, config_cmd_ublox_hw);
+    uint16_t count = 0;
+    do {
+        config_cmd_apply(&config_cmd_txn, &cmd);
+        count++;
+    } while (config_cmd_pop(&cmd));
+    config_metric_end(cfg_metric_set, start);
+    // commands were checked one by one, a failure here is the save itself
+    esp_err_t ret = config_txn_commit(&config_cmd_txn);
+    if (ret == ESP_ERR_NOT_FINISHED)
+        DLOG(TAG, "[%s] %u commands saved, view publish retried", __func__, count);
+    else if (ret != ESP_OK)
+        ESP_LOGE(TAG, "[%s] batch of %u commands not saved: %d", __func__, count, ret);
+    else
+        DLOG(TAG, "[%s] %u commands", __func__, count);
+}
+
+static void config_cmd_task(void *arg) {
+    while (!atomic_load(&config_cmd_stopping)) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        config_cmd_drain();
+    }
+    config_cmd_drain(); // whatever was queued before the stop still counts
+    atomic_store(&config_cmd_task_handle, 0);
+    vTaskDelete(0);
+}
+
+esp_err_t config_service_start(logger_config_t *config, uint8_t ublox_hw) {
+    if (!config)
+        return ESP_ERR_INVALID_ARG;
+    config_cmd_config = config;
+    config_cmd_ublox_hw = ublox_hw;
+    if (atomic_load(&config_cmd_task_handle))
+        return ESP_OK;
+    for (unsigned i = 0; i < CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN; i++)
+        atomic_store(&config_cmd_queue[i].seq, config_cmd_tail + i);
+    atomic_store(&config_cmd_head, config_cmd_tail);
+    TaskHandle_t task = 0;
+    if (xTaskCreate(config_cmd_task, "config_cmd", CONFIG_LOGGER_CONFIG_CMD_TASK_STACK, 0, tskIDLE_PRIORITY + 1, &task) != pdPASS) {
+        ESP_LOGE(TAG, "[%s] no command task", __func__);
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_store(&config_cmd_task_handle, task);
+    xTaskNotifyGive(task); // commands queued while it was created
+    return ESP_OK;
+}
+
+void config_service_stop(void) {
+    TaskHandle_t task = atomic_load(&config_cmd_task_handle);
+    if (!task)
+        return;
+    atomic_store(&config_cmd_stopping, 1);
+    xTaskNotifyGive(task);
+    while (atomic_load(&config_cmd_task_handle))
+        vTaskDelay(1);
+    atomic_store(&config_cmd_stopping, 0);
+}
+
+static esp_err_t config_cmd_check(int item) {
+    if (!atomic_load(&config_cmd_task_handle))
+        return ESP_ERR_INVALID_STATE;
+    if (item < 0 || item >= config_item_count)
+        return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+esp_err_t config_cmd_set_num(config_item_t item, double value) {
+    esp_err_t ret = config_cmd_check(item);
+    if (ret != ESP_OK)
+        return ret;
+    if (config_fields[item].type == CFG_T_STR)
+        return ESP_ERR_INVALID_ARG;
+    config_cmd_t cmd = { .op = CFG_CMD_SET_NUM, .item = item, .num = value };
+    return config_cmd_push(&cmd);
+}
+
+esp_err_t config_cmd_set_str(config_item_t item, const char *value) {
+    esp_err_t ret = config_cmd_check(item);
+    if (ret != ESP_OK)
+        return ret;
+    if (!value || config_fields[item].type != CFG_T_STR)
+        return ESP_ERR_INVALID_ARG;
+    config_cmd_t cmd = { .op = CFG_CMD_SET_STR, .item = item };
+    size_t len = strlen(value);
+    if (len >= sizeof(cmd.str))
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(cmd.str, value, len + 1);
+    return config_cmd_push(&cmd);
+}
+
+esp_err_t config_cmd_step(config_item_t item) {
+    esp_err_t ret = config_cmd_check(item);
+    if (ret != ESP_OK)
+        return ret;
+    if (config_fields[item].step == CFG_STEP_NONE)
+        return ESP_ERR_INVALID_ARG;
+    config_cmd_t cmd = { .op = CFG_CMD_STEP, .item = item };
+    return config_cmd_push(&cmd);
+}
+
+#endif
@@ -0,0 +1,341 @@
+#include <string.h>
+
+#include "logger_config.h"
+#include "config_fields.h"
+
+#define SPEED_FIELD_ITEM_LIST(l) l(dynamic) l(stat_10_sec) l(stat_alpha) l(stat_1852_m) l(stat_dist_500m) l(stat_max_2s_10s) l(stat_half_hour) l(stat_1_hour) l(stat_1h_dynamic)
+#define STAT_SCREEN_ITEM_LIST(l) l(stat_10_sec) l(stat_2_sec) l(stat_250_m) l(stat_500_m) l(stat_1852_m) l(stat_a500) l(stat_avg_10sec) l(stat_stat1) l(stat_avg_a500)
+
+#define BOARD_LOGO_ITEM_LIST(l) l(Starboard) l(Fanatic) l(JP) l(Patrik)
+#define SAIL_LOGO_ITEM_LIST(l) l(GASails) l(Duotone) l(NeilPryde) l(LoftSails) l(Gunsails) l(Point7) l(Patrik)
+
+#define SPEED_UNIT_ITEM_LIST(l) l(m/s) l(km/h) l(knots)
+#define SAMPLE_RATE_ITEM_LIST(l) l(1 Hz) l(5 Hz) l(10 Hz) l(16 Hz) l(20 Hz)
+#define SCREEN_ROTATION_ITEM_LIST(l) l(0_deg) l(90_deg) l(180_deg) l(270_deg)
+#define FW_UPDATE_CHANNEL_ITEM_LIST(l) l(stable) l(unstable)
+
+const char * const config_stat_screen_items[] = { STAT_SCREEN_ITEM_LIST(STRINGIFY) };
+const size_t config_stat_screen_item_count = lengthof(config_stat_screen_items);
+const char * const config_speed_field_items[] = { SPEED_FIELD_ITEM_LIST(STRINGIFY) };
+const size_t config_speed_field_item_count = lengthof(config_speed_field_items);
+
+const char * const board_logos[] = {BOARD_LOGO_ITEM_LIST(STRINGIFY)};
+const char * const sail_logos[] = {SAIL_LOGO_ITEM_LIST(STRINGIFY)};
+const char * const speed_units[] = {SPEED_UNIT_ITEM_LIST(STRINGIFY)};
+const char * const sample_rates[] = {SAMPLE_RATE_ITEM_LIST(STRINGIFY)};
+const char * const screen_rotations[] = {SCREEN_ROTATION_ITEM_LIST(STRINGIFY)};
+const char * const channels[] = {FW_UPDATE_CHANNEL_ITEM_LIST(STRINGIFY)};
+const char * const not_set = "not set";
+
+#define CFG_LIST(t, ...) &(const config_field_list_t){ .titles = t, .count = lengthof(t), __VA_ARGS__ }
+
+static const int16_t gnss_values[] = {39, 43, 99, 47, 103, 107, 111};
+static const char * const gnss_titles[] = {
+    "GPS(G) + GALILEO(E)",
+    "GPS(G) + BEIDOU(B)",
+    "GPS(G) + GLONASS(R)",
+    "GPS(G) + GALILEO(E) + BEIDOU(B)",
+    "GPS(G) + GALILEO(E) + GLONASS(R)",
+    "GPS(G) + BEIDOU(B) + GLONASS(R)",
+    "GPS(G) + GALILEO(E) + BEIDOU(B) + GLONASS(R)",
+};
+static const char * const gnss_menu[] = {"G + E", "G + B", "G + R", "G + E + B", "G + E + R", "G + B + R", "G + E + B + R"};
+static const int16_t sample_rate_values[] = {1, 5, 10, 16, 20};
+static const char * const timezone_titles[] = {"GMT0", "GMT+1", "GMT+2", "GMT+3"};
+static const char * const timezone_menu[] = {"UTC+1", "UTC+2", "UTC+3"};
+static const char * const dynamic_model_titles[] = {"Portable", "Sea", "Automotive"};
+static const char * const dynamic_model_menu[] = {"portable", "sea", "automotive"};
+static const char * const stat_screens_time_titles[] = {"1 sec", "2 sec", "3 sec", "4 sec", "5 sec"};
+#if defined(CONFIG_DISPLAY_DRIVER_ST7789)
+static const int16_t brightness_values[] = {20, 40, 60, 80, 100};
+static const char * const brightness_titles[] = {"20", "40", "60", "80", "100"};
+#endif
+static const int16_t file_date_time_values[] = {1, 0, 2};
+static const char * const file_date_time_titles[] = {"name_date_time", "name_MAC_index", "date_time_name"};
+static const char * const yes_no[] = {"no", "yes"};
+
+#define CFG_BOOL(i) .step = CFG_STEP_TOGGLE, .info = i
+#define CFG_WIFI(i) .flags = CFG_F_SKIP_EMPTY, .info = i
+
+#define CFG_META_cal_bat .prec = 4, .info = "calibration for read out bat voltage", .ext = "V"
+#define CFG_META_gnss .step = CFG_STEP_PREV, .info = " default For M10 default 3 gnss: GPS(G) + GALILEO(B) + GLONASS(R)", \
+    .values = CFG_LIST(gnss_titles, .values = gnss_values), .menu = CFG_LIST(gnss_menu, .values = gnss_values)
+#define CFG_META_sample_rate .step = CFG_STEP_PREV, .info = "gps_rate in Hz", .ext = "Hz", \
+    .values = CFG_LIST(sample_rates, .values = sample_rate_values)
+#define CFG_META_timezone .step = CFG_STEP_NEXT, .info = "timezone: The local time difference in hours with UTC", .ext = "h", \
+    .values = CFG_LIST(timezone_titles), .menu = CFG_LIST(timezone_menu, .first = 1), .unset = "UTC"
+#define CFG_META_speed_unit .step = CFG_STEP_PREV, .info = "Speed display units", .values = CFG_LIST(speed_units)
+#define CFG_META_log_txt CFG_BOOL("log to .txt")
+#define CFG_META_log_ubx CFG_BOOL("log to .ubx")
+#define CFG_META_log_sbp CFG_BOOL("log to .sbp")
+#define CFG_META_log_gpy CFG_BOOL("log to .gpy")
+#define CFG_META_log_gpx CFG_BOOL("log to .gpx")
+#define CFG_META_log_ubx_nav_sat CFG_BOOL("log nav sat msg to .ubx")
+#define CFG_META_dynamic_model .flags = CFG_F_UBX_M8, .step = CFG_STEP_PREV, \
+    .info = "choice for dynamic model 'Sea', if 0 model 'Portable' is used !!", \
+    .values = CFG_LIST(dynamic_model_titles), .menu = CFG_LIST(dynamic_model_menu), .unset = "portable"
+#define CFG_META_speed_field .step = CFG_STEP_RANGE, .info = "choice for first field in speed screen", \
+    .values = CFG_LIST(config_speed_field_items, .first = 1)
+#define CFG_META_stat_screens_time .step = CFG_STEP_PREV, .info = "The time between toggle the different stat screens", \
+    .values = CFG_LIST(stat_screens_time_titles, .first = 1)
+#define CFG_META_stat_screens .info = "Stat_screens choice : activate / deactivate screens to show.", \
+    .values = CFG_LIST(config_stat_screen_items), .unset = "menu"
+#define CFG_META_board_logo .step = CFG_STEP_RANGE, .info = "Board_Logo", .values = CFG_LIST(board_logos, .first = 1)
+#define CFG_META_sail_logo .step = CFG_STEP_RANGE, .info = "Sail Logo", .values = CFG_LIST(sail_logos, .first = 1)
+#define CFG_META_screen_rotation .step = CFG_STEP_RANGE, .info = "screen rotation degrees", .values = CFG_LIST(screen_rotations)
+#define CFG_META_screen_move_offset CFG_BOOL("move epd sceen content to pervent panel burn")
+#define CFG_META_screen_brightness .step = CFG_STEP_PREV, .info = "Display brightness", \
+    .values = CFG_LIST(brightness_titles, .values = brightness_values)
+#define CFG_META_update_enabled CFG_BOOL("wether to allow automatic firmware updates or not"), .menu = CFG_LIST(yes_no)
+#define CFG_META_update_channel .step = CFG_STEP_RANGE, .info = "automatic firmware update channel", .values = CFG_LIST(channels)
+#define CFG_META_speed_large_font CFG_BOOL("fonts on the first line are bigger, actual speed font is smaller")
+#define CFG_META_bar_length .info = "bar_length: Default length = 1852 m for 100% bar (=Nautical mile)", .ext = "m"
+#define CFG_META_stat_speed .info = "max speed in m/s for showing Stat screens", .ext = "m/s"
+#define CFG_META_archive_days .info = "how many days files will be moved to the 'Archive' dir", .ext = "d"
+#define CFG_META_file_date_time .info = "type of filenaming, with MAC adress or datetime", \
+    .values = CFG_LIST(file_date_time_titles, .values = file_date_time_values)
+#define CFG_META_ssid CFG_WIFI("wifi ssid")
+#define CFG_META_password CFG_WIFI("wifi network password")
+#define CFG_META_ssid1 CFG_META_ssid
+#define CFG_META_password1 CFG_META_password
+#define CFG_META_ssid2 CFG_META_ssid
+#define CFG_META_password2 CFG_META_password
+#define CFG_META_ssid3 CFG_META_ssid
+#define CFG_META_password3 CFG_META_password
+#define CFG_META_gpio12_screens \
+    .info = "GPIO12_screens choice : Every digit shows the according GPIO_screen after each push. Screen 4 = s10 runs, screen 5 = alfa's."
+#define CFG_META_ubx_file .info = "your preferred filename"
+#define CFG_META_sleep_info .info = "your preferred sleep text"
+#define CFG_META_hostname .info = "hostname: the hostname of the device for present itself in the network"
+
+#define CFG_FIELD_STORAGE(n, ...) CFG_FIELD_STORAGE_I(n, __VA_ARGS__)
+#define CFG_FIELD_STORAGE_I(n, member, kind) .name = #n, .offset = offsetof(logger_config_t, member), \
+    .size = sizeof(((logger_config_t *)0)->member), CFG_FIELD_KIND_##kind(n)
+#define CFG_FIELD_KIND_UINT(n) .type = CFG_T_UINT
+#define CFG_FIELD_KIND_INT(n) .type = CFG_T_INT
+#define CFG_FIELD_KIND_BOOL(n) .type = CFG_T_BOOL
+#define CFG_FIELD_KIND_BITS(n) .type = CFG_T_BITS
+#define CFG_FIELD_KIND_FLOAT(n) .type = CFG_T_FLOAT
+#define CFG_FIELD_KIND_STR(n) .type = CFG_T_STR
+#define CFG_FIELD_KIND_FLAG(n) .type = CFG_T_BOOL, .mask = 1 << cfg_flag_##n
+#define CFG_FIELD_RANGE(...) CFG_FIELD_RANGE_I(__VA_ARGS__)
+#define CFG_FIELD_RANGE_I(lo, hi) .min = lo, .max = hi
+#define CFG_FIELD_ENTRY(n) [cfg_##n] = { CFG_FIELD_STORAGE(n, CFG_FIELD_##n), CFG_FIELD_RANGE(CFG_RANGE_##n), CFG_META_##n },
+
+const config_field_t config_fields[] = {
+    CFG_CALIBRATION_ITEM_LIST(CFG_FIELD_ENTRY)
+    CFG_GPS_ITEM_LIST(CFG_FIELD_ENTRY)
+    CFG_SCREEN_ITEM_LIST(CFG_FIELD_ENTRY)
+    CFG_SCREEN_ITEM_LIST_A(CFG_FIELD_ENTRY)
+    CFG_FW_UPDATE_ITEM_LIST(CFG_FIELD_ENTRY)
+    CFG_ITEM_LIST(CFG_FIELD_ENTRY)
+};
+
+_Static_assert(sizeof(logger_config_hot_t) <= CFG_HOT_BLOCK_MAX, "hot settings outgrew a cache line");
+
+int32_t config_field_get_int(const config_field_t *f, const logger_config_t *config) {
+    const uint8_t *p = CFG_FIELD_PTR(f, config);
+    if (f->mask)
+        return (*p & f->mask) ? 1 : 0;
+    switch (f->type) {
+    case CFG_T_FLOAT:
+        return (int32_t)config_field_get_float(f, config);
+    case CFG_T_STR:
+        return 0;
+    case CFG_T_INT:
+        switch (f->size) {
+        case 1: return *(const int8_t *)p;
+        case 2: return *(const int16_t *)p;
+        default: return *(const int32_t *)p;
+        }
+    default:
+        switch (f->size) {
+        case 1: return *p;
+        case 2: return *(const uint16_t *)p;
+        default: return *(const uint32_t *)p;
+        }
+    }
+}
+
+float config_field_get_float(const config_field_t *f, const logger_config_t *config) {
+    if (f->type != CFG_T_FLOAT)
+        return config_field_get_int(f, config);
+    float val;
+    memcpy(&val, CFG_FIELD_PTR(f, config), sizeof(val));
+    return val;
+}
+
+/// store val in field storage width, 1 when stored bytes changed
+int config_field_set_num(const config_field_t *f, logger_config_t *config, double val, uint8_t force) {
+    uint8_t *p = CFG_FIELD_PTR(f, config);
+    if (f->mask) {
+        uint8_t b = val != 0 ? (*p | f->mask) : (*p & ~f->mask);
+        if (!force && b == *p)
+            return 0;
+        *p = b;
+        return 1;
+    }
+    union {
+        uint8_t u8;
+        int8_t i8;
+        uint16_t u16;
+        int16_t i16;
+        uint32_t u32;
+        int32_t i32;
+        float fl;
+    } v = {0};
+    switch (f->type) {
+    case CFG_T_STR:
+        return 0;
+    case CFG_T_FLOAT:
+        v.fl = val;
+        break;
+    case CFG_T_BOOL:
+        v.u8 = val != 0;
+        break;
+    case CFG_T_INT:
+        if (f->size == 1) v.i8 = val;
+        else if (f->size == 2) v.i16 = val;
+        else v.i32 = val;
+        break;
+    default:
+        if (f->size == 1) v.u8 = val;
+        else if (f->size == 2) v.u16 = val;
+        else v.u32 = val;
+        break;
+    }
+    if (!force && !memcmp(p, &v, f->size))
+        return 0;
+    memcpy(p, &v, f->size);
+    return 1;
+}
+
+int config_field_set_str(const config_field_t *f, logger_config_t *config, const char *val, size_t len, uint8_t force) {
+    if (f->type != CFG_T_STR)
+        return 0;
+    char *p = (char *)CFG_FIELD_PTR(f, config);
+    if (len > f->size - 1)
+        len = f->size - 1;
+    if (!force && !strncmp(p, val, len) && p[len] == 0)
+        return 0;
+    memcpy(p, val, len);
+    p[len] = 0;
+    return 1;
+}
+
+int config_field_equal(const config_field_t *f, const logger_config_t *a, const logger_config_t *b) {
+    if (f->type == CFG_T_STR)
+        return !strncmp((const char *)CFG_FIELD_PTR(f, a), (const char *)CFG_FIELD_PTR(f, b), f->size);
+    if (f->mask)
+        return !((*CFG_FIELD_PTR(f, a) ^ *CFG_FIELD_PTR(f, b)) & f->mask);
+    return !memcmp(CFG_FIELD_PTR(f, a), CFG_FIELD_PTR(f, b), f->size);
+}
+
+/// value of one item from src into dst, flags sharing its byte are left alone
+void config_field_copy(const config_field_t *f, logger_config_t *dst, const logger_config_t *src) {
+    uint8_t *d = CFG_FIELD_PTR(f, dst);
+    const uint8_t *s = CFG_FIELD_PTR(f, src);
+    if (f->mask)
+        *d = (*d & ~f->mask) | (*s & f->mask);
+    else
+        memcpy(d, s, f->size);
+}
+
+// hot and cold block compared with one memcmp each, their fields are only looked at when the block differs,
+// the callback pointer and its subscription at the end of the cold block are no items
+static const struct { uint16_t offset, size; } config_field_blocks[] = {
+    { offsetof(logger_config_t, hot), sizeof(logger_config_hot_t) },
+    { offsetof(logger_config_t, cold), offsetof(logger_config_cold_t, config_changed_screen_cb) },
+};
+#define CFG_FIELD_BLOCK_COLD 1
+static config_change_mask_t config_field_block_masks[lengthof(config_field_blocks)] = {0};
+static config_change_mask_t config_field_loose_mask = 0; // fields outside any block
+static uint8_t config_field_blocks_ready = 0;
+
+static void config_field_blocks_build(void) {
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        const config_field_t *f = &config_fields[i];
+        uint8_t j = 0;
+        for (; j < lengthof(config_field_blocks); j++) {
+            if (f->offset >= config_field_blocks[j].offset && f->offset < config_field_blocks[j].offset + config_field_blocks[j].size)
+                break;
+        }
+        if (j < lengthof(config_field_blocks))
+            config_field_block_masks[j] |= 1ULL << i;
+        else
+            config_field_loose_mask |= 1ULL << i;
+    }
+    config_field_blocks_ready = 1;
+}
+
+static inline config_change_mask_t config_field_diff_mask(config_change_mask_t m, const logger_config_t *a, const logger_config_t *b) {
+    config_change_mask_t ret = 0;
+    for (; m; m &= m - 1) {
+        uint8_t i = __builtin_ctzll(m);
+        if (!config_field_equal(&config_fields[i], a, b))
+            ret |= 1ULL << i;
+    }
+    return ret;
+}
+
+config_change_mask_t config_field_cold_items(void) {
+    if (!config_field_blocks_ready)
+        config_field_blocks_build();
+    return config_field_block_masks[CFG_FIELD_BLOCK_COLD];
+}
+
+config_change_mask_t config_diff(const logger_config_t *orig, const logger_config_t *config) {
+    if (!orig || !config || orig == config)
+        return 0;
+    if (!config_field_blocks_ready)
+        config_field_blocks_build();
+    config_change_mask_t ret = config_field_diff_mask(config_field_loose_mask, orig, config);
+    for (uint8_t j = 0; j < lengthof(config_field_blocks); j++) {
+        const uint8_t *a = (const uint8_t *)orig + config_field_blocks[j].offset, *b = (const uint8_t *)config + config_field_blocks[j].offset;
+        if (memcmp(a, b, config_field_blocks[j].size)) // padding or bytes past a string end may differ too
+            ret |= config_field_diff_mask(config_field_block_masks[j], orig, config);
+    }
+    return ret;
+}
+
+/// title of val, menu titles preferred when menu set, 0 when unlabelled
+const char *config_field_label(const config_field_t *f, int32_t val, uint8_t menu) {
+    const config_field_list_t *l = (menu && f->menu) ? f->menu : f->values;
+    if (!l)
+        return 0;
+    for (uint8_t i = 0; i < l->count; i++) {
+        if (config_field_list_value(l, i) == val)
+            return l->titles[i];
+    }
+    return 0;
+}
+
+void config_field_step(const config_field_t *f, logger_config_t *config) {
+    int32_t val = config_field_get_int(f, config);
+    const config_field_list_t *l = f->menu ? f->menu : f->values;
+    switch (f->step) {
+    case CFG_STEP_TOGGLE:
+        val = val ? 0 : 1;
+        break;
+    case CFG_STEP_RANGE:
+        val = (val >= f->max || val < f->min) ? f->min : val + 1;
+        break;
+    case CFG_STEP_NEXT:
+    case CFG_STEP_PREV: {
+        if (!l || !l->count)
+            return;
+        int16_t i = 0;
+        while (i < l->count && config_field_list_value(l, i) != val)
+            i++;
+        if (f->step == CFG_STEP_NEXT)
+            i = (i >= l->count - 1) ? 0 : i + 1;
+        else
+            i = (i == 0 || i >= l->count) ? l->count - 1 : i - 1;
+        val = config_field_list_value(l, i);
+        break;
+    }
+    default:
+        return;
+    }
+    config_field_set_num(f, config, val, 0);
+}
@@ -0,0 +1,98 @@
+#ifndef B0A3A6E2_7C1D_4F7E_9E57_2D6B4C1F8A90
+#define B0A3A6E2_7C1D_4F7E_9E57_2D6B4C1F8A90
+
+#include <stdint.h>
+#include <stddef.h>
+#include "logger_config.h"
+#include "ubx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CFG_T_UINT,
+    CFG_T_INT,
+    CFG_T_BOOL,
+    CFG_T_BITS,   // bitmask, one toggle per title
+    CFG_T_FLOAT,
+    CFG_T_STR,
+} config_field_type_t;
+
+typedef enum {
+    CFG_STEP_NONE,
+    CFG_STEP_TOGGLE, // 0 <-> 1
+    CFG_STEP_RANGE,  // min..max upwards, wraps to min
+    CFG_STEP_NEXT,   // next labelled value, wraps to first
+    CFG_STEP_PREV,   // previous labelled value, wraps to last
+} config_field_step_t;
+
+#define CFG_F_SKIP_EMPTY 0x01 // not encoded when empty string
+#define CFG_F_UBX_M8 0x02     // only available with ublox M8
+
+typedef struct config_field_list_s {
+    const char * const *titles;
+    const int16_t *values; // value of each title, first + index when null
+    int16_t first;
+    uint8_t count;
+} config_field_list_t;
+
+typedef struct config_field_s {
+    const char *name;
+    uint16_t offset;
+    uint8_t size;
+    uint8_t mask;     // bit of a FLAG item in the byte at offset, 0 for whole members
+    uint8_t type;     // config_field_type_t
+    uint8_t flags;    // CFG_F_*
+    uint8_t step;     // config_field_step_t, menu stepping
+    uint8_t prec;     // decimals when encoding float
+    int32_t min, max; // accepted value range
+    const char *info;
+    const char *ext;
+    const config_field_list_t *values; // labelled values for web ui
+    const config_field_list_t *menu;   // menu labels, values used when null
+    const char *unset;                 // menu text for unlabelled value
+} config_field_t;
+
+extern const config_field_t config_fields[];
+extern const char * const config_speed_field_items[];
+extern const char * const config_stat_screen_items[];
+extern const char * const not_set;
+
+#define CFG_FIELD_PTR(f, c) ((uint8_t *)(c) + (f)->offset)
+
+static inline int16_t config_field_list_value(const config_field_list_t *l, uint8_t i) {
+    return l->values ? l->values[i] : l->first + i;
+}
+
+/// val within the accepted range, checked before it is narrowed to the storage width
+static inline int config_field_in_range(const config_field_t *f, double val) {
+    return val >= f->min && val <= f->max;
+}
+
+int32_t config_field_get_int(const config_field_t *f, const logger_config_t *config);
+float config_field_get_float(const config_field_t *f, const logger_config_t *config);
+int config_field_set_num(const config_field_t *f, logger_config_t *config, double val, uint8_t force);
+int config_field_set_str(const config_field_t *f, logger_config_t *config, const char *val, size_t len, uint8_t force);
+int config_field_equal(const config_field_t *f, const logger_config_t *a, const logger_config_t *b);
+void config_field_copy(const config_field_t *f, logger_config_t *dst, const logger_config_t *src);
+
+/// items stored in the cold block
+config_change_mask_t config_field_cold_items(void);
+const char *config_field_label(const config_field_t *f, int32_t val, uint8_t menu);
+void config_field_step(const config_field_t *f, logger_config_t *config);
+
+/// item left out of the saved file and web ui
+static inline int config_field_hidden(const config_field_t *f, const logger_config_t *config, uint8_t ublox_hw) {
+    return ((f->flags & CFG_F_UBX_M8) && ublox_hw != UBX_TYPE_M8)
+        || ((f->flags & CFG_F_SKIP_EMPTY) && !*CFG_FIELD_PTR(f, config));
+}
+
+/// resolve name of len chars to config_item_t, -1 when unknown, *alias set for legacy spelling
+int config_item_find(const char *name, size_t len, uint8_t *alias);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* B0A3A6E2_7C1D_4F7E_9E57_2D6B4C1F8A90 */
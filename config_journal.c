@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_port.h"
+#include "config_snapshot.h"
+#include "config_journal.h"
+
+static const char *TAG = "config_journal";
+
+// record is a snapshot record followed by crc8 over it, so a torn append is detected on replay
+#define CFG_JOURNAL_REC_MAX (CFG_SNAPSHOT_REC_HDR + UINT8_MAX + 1)
+
+static size_t config_journal_len = 0; // 0 until the journal matches the current snapshot
+
+size_t config_journal_size(void) {
+    return config_journal_len;
+}
+
+esp_err_t config_journal_reset(const char *path, uint32_t snapshot_crc) {
+    config_journal_hdr_t hdr = { .magic = CFG_JOURNAL_MAGIC, .snapshot_crc = snapshot_crc };
+    config_journal_len = 0;
+    if (!path || config_port_write(path, 0, &hdr, sizeof(hdr)))
+        return ESP_FAIL;
+    config_journal_len = sizeof(hdr);
+    return ESP_OK;
+}
+
+esp_err_t config_journal_append(const logger_config_t *config, const char *path, uint8_t item) {
+    if (!config_journal_len || !path)
+        return ESP_ERR_INVALID_STATE;
+    uint8_t rec[CFG_JOURNAL_REC_MAX];
+    size_t len = config_snapshot_put_record(config, item, rec, sizeof(rec) - 1);
+    if (!len)
+        return ESP_FAIL;
+    rec[len] = esp_rom_crc8_le(0, rec, len);
+    len++;
+    if (config_journal_len + len > CONFIG_LOGGER_CONFIG_JOURNAL_MAX_SIZE)
+        return ESP_ERR_INVALID_STATE;
+    if (config_port_write(path, 1, rec, len)) {
+        config_journal_len = 0;
+        return ESP_FAIL;
+    }
+    config_journal_len += len;
+    DLOG(TAG, "[%s] %s, journal %u bytes", __func__, config_items[item], (unsigned)config_journal_len);
+    return ESP_OK;
+}
+
+esp_err_t config_journal_replay(logger_config_t *config, const char *path, uint32_t snapshot_crc) {
+    config_journal_len = 0;
+    if (!path)
+        return ESP_FAIL;
+    FILE *fd = fopen(path, "rb");
+    if (!fd)
+        return ESP_ERR_NOT_FOUND;
+    esp_err_t ret = ESP_OK;
+    config_journal_hdr_t hdr;
+    uint8_t rec[CFG_JOURNAL_REC_MAX];
+    size_t len = sizeof(hdr);
+    uint16_t count = 0;
+    if (fread(&hdr, 1, sizeof(hdr), fd) != sizeof(hdr) || hdr.magic != CFG_JOURNAL_MAGIC || hdr.snapshot_crc != snapshot_crc) {
+        // left over from before the last compaction, everything in it is in the snapshot
+        ret = ESP_ERR_INVALID_VERSION;
+        goto done;
+    }
+    while (fread(rec, 1, CFG_SNAPSHOT_REC_HDR, fd) == CFG_SNAPSHOT_REC_HDR) {
+        size_t n = CFG_SNAPSHOT_REC_HDR + rec[2];
+        if (fread(rec + CFG_SNAPSHOT_REC_HDR, 1, rec[2] + 1, fd) != rec[2] + 1u || esp_rom_crc8_le(0, rec, n) != rec[n]) {
+            ESP_LOGW(TAG, "[%s] torn record after %u", __func__, count);
+            ret = ESP_ERR_INVALID_CRC;
+            goto done;
+        }
+        config_snapshot_apply_record(config, rec);
+        len += n + 1;
+        count++;
+    }
+    config_journal_len = len;
+done:
+    config_metric_bytes(ftell(fd), 0);
+    fclose(fd);
+    ILOG(TAG, "[%s] %u records", __func__, count);
+    return ret;
+}
@@ -0,0 +1,41 @@
+#ifndef A4F81D27_96C3_4E0B_8D52_1B7E6C3A09F5
+#define A4F81D27_96C3_4E0B_8D52_1B7E6C3A09F5
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "logger_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(CONFIG_LOGGER_CONFIG_JOURNAL_MAX_SIZE)
+#define CONFIG_LOGGER_CONFIG_JOURNAL_MAX_SIZE 2048
+#endif
+
+#define CFG_JOURNAL_MAGIC 0x4a46434cU // "LCFJ"
+
+/// journal file header, records only apply on top of the snapshot with this crc
+typedef struct __attribute__((packed)) config_journal_hdr_s {
+    uint32_t magic;
+    uint32_t snapshot_crc;
+} config_journal_hdr_t;
+
+/// start an empty journal for the snapshot with crc
+esp_err_t config_journal_reset(const char *path, uint32_t snapshot_crc);
+
+/// append record of one item, ESP_ERR_INVALID_STATE when the journal has to be compacted first
+esp_err_t config_journal_append(const logger_config_t *config, const char *path, uint8_t item);
+
+/// apply records on top of the snapshot with crc, stops at the first torn record
+esp_err_t config_journal_replay(logger_config_t *config, const char *path, uint32_t snapshot_crc);
+
+/// bytes in the journal, 0 when it has to be compacted before the next append
+size_t config_journal_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* A4F81D27_96C3_4E0B_8D52_1B7E6C3A09F5 */
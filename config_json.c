@@ -0,0 +1,388 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_fields.h"
+#include "config_json.h"
+
+static const char *TAG = "config_json";
+
+enum {
+    P_START,     // before top level object
+    P_KEY_FIRST, // key or end of empty object
+    P_KEY_NEXT,  // key after comma
+    P_KEY,       // inside key string
+    P_COLON,
+    P_VALUE,
+    P_STR,       // inside string value
+    P_LIT,       // number or true/false/null
+    P_SKIP,      // inside nested object or array
+    P_SKIP_STR,  // inside string of nested value
+    P_NEXT,      // comma or end of object
+    P_END,       // trailing whitespace only
+    P_ERR,
+};
+
+#define IS_WS(c) ((c) == ' ' || (c) == '\n' || (c) == '\r' || (c) == '\t')
+
+void config_json_parser_init(config_json_parser_t *p, logger_config_t *config, size_t max) {
+    memset(p, 0, sizeof(*p));
+    p->config = config;
+    p->max = max ? max : CONFIG_LOGGER_CONFIG_JSON_MAX_SIZE;
+    p->item = -1;
+}
+
+static inline void buf_put(config_json_parser_t *p, char c) {
+    if (p->len < CFG_JSON_TOKEN_MAX - 1)
+        p->buf[p->len++] = c;
+}
+
+static void buf_put_utf8(config_json_parser_t *p, uint16_t cp) {
+    if (cp < 0x80) {
+        buf_put(p, cp);
+    } else if (cp < 0x800) {
+        buf_put(p, 0xC0 | (cp >> 6));
+        buf_put(p, 0x80 | (cp & 0x3F));
+    } else {
+        buf_put(p, 0xE0 | (cp >> 12));
+        buf_put(p, 0x80 | ((cp >> 6) & 0x3F));
+        buf_put(p, 0x80 | (cp & 0x3F));
+    }
+}
+
+static inline int hex_val(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/// string char with escapes, 1 when closing quote reached, -1 on bad escape
+static int str_char(config_json_parser_t *p, char c, uint8_t keep) {
+    if (p->esc == 1) {
+        p->esc = 0;
+        switch (c) {
+        case '"': case '\\': case '/': break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'u': p->esc = 2; p->ucode = 0; return 0;
+        default: return -1;
+        }
+        if (keep) buf_put(p, c);
+        return 0;
+    }
+    if (p->esc >= 2) { // \uXXXX, esc counts hex digits read + 2
+        int v = hex_val(c);
+        if (v < 0)
+            return -1;
+        p->ucode = (p->ucode << 4) | v;
+        if (++p->esc == 6) {
+            p->esc = 0;
+            if (keep) buf_put_utf8(p, p->ucode);
+        }
+        return 0;
+    }
+    if (c == '\\') {
+        p->esc = 1;
+        return 0;
+    }
+    if (c == '"')
+        return 1;
+    if ((uint8_t)c < 0x20)
+        return -1;
+    if (keep) buf_put(p, c);
+    return 0;
+}
+
+static void set_value(config_json_parser_t *p, const char *str, size_t len, double num, uint8_t is_str) {
+    if (p->item < 0)
+        return;
+    const config_field_t *f = &config_fields[p->item];
+    int changed;
+    if (is_str != (f->type == CFG_T_STR)) {
+        WLOG(TAG, "[%s] type mismatch: %s", __func__, f->name);
+        return;
+    }
+    if (is_str)
+        changed = config_field_set_str(f, p->config, str, len, 0);
+    else
+        changed = config_field_set_num(f, p->config, num, 0);
+    p->done |= (1ULL << p->item);
+    if (changed)
+        p->changed |= (1ULL << p->item);
+}
+
+static int end_literal(config_json_parser_t *p) {
+    p->buf[p->len] = 0;
+    if (!strcmp(p->buf, "true")) {
+        if (p->item >= 0 && config_fields[p->item].type == CFG_T_BOOL)
+            set_value(p, 0, 0, 1, 0);
+        return 0;
+    }
+    if (!strcmp(p->buf, "false")) {
+        if (p->item >= 0 && config_fields[p->item].type == CFG_T_BOOL)
+            set_value(p, 0, 0, 0, 0);
+        return 0;
+    }
+    if (!strcmp(p->buf, "null"))
+        return 0;
+    for (const char *s = p->buf; *s; s++) {
+        if (!((*s >= '0' && *s <= '9') || *s == '-' || *s == '+' || *s == '.' || *s == 'e' || *s == 'E'))
+            return -1;
+    }
+    char *end = 0;
+    double num = strtod(p->buf, &end);
+    if (!p->len || *end)
+        return -1;
+    set_value(p, 0, 0, num, 0);
+    return 0;
+}
+
+static int feed_char(config_json_parser_t *p, char c) {
+    int r;
+    switch (p->state) {
+    case P_START:
+        if (IS_WS(c)) return 0;
+        if (c != '{') return -1;
+        p->state = P_KEY_FIRST;
+        return 0;
+    case P_KEY_FIRST:
+    case P_KEY_NEXT:
+        if (IS_WS(c)) return 0;
+        if (c == '}' && p->state == P_KEY_FIRST) {
+            p->state = P_END;
+            return 0;
+        }
+        if (c != '"') return -1;
+        p->len = 0;
+        p->state = P_KEY;
+        return 0;
+    case P_KEY:
+        if ((r = str_char(p, c, 1)) < 0) return -1;
+        if (r) {
+            p->item = config_item_find(p->buf, p->len, &p->alias);
+            // canonical name wins over any legacy spelling of the same item
+            if (p->item >= 0 && p->alias && (p->done & (1ULL << p->item)))
+                p->item = -1;
+            p->state = P_COLON;
+        }
+        return 0;
+    case P_COLON:
+        if (IS_WS(c)) return 0;
+        if (c != ':') return -1;
+        p->state = P_VALUE;
+        return 0;
+    case P_VALUE:
+        if (IS_WS(c)) return 0;
+        p->len = 0;
+        if (c == '"') {
+            p->state = P_STR;
+        } else if (c == '{' || c == '[') {
+            if (p->item >= 0)
+                WLOG(TAG, "[%s] type mismatch: %s", __func__, config_fields[p->item].name);
+            p->depth = 1;
+            p->state = P_SKIP;
+        } else {
+            buf_put(p, c);
+            p->state = P_LIT;
+        }
+        return 0;
+    case P_STR:
+        if ((r = str_char(p, c, 1)) < 0) return -1;
+        if (r) {
+            set_value(p, p->buf, p->len, 0, 1);
+            p->state = P_NEXT;
+        }
+        return 0;
+    case P_LIT:
+        if (IS_WS(c) || c == ',' || c == '}') {
+            if (end_literal(p)) return -1;
+            p->state = P_NEXT;
+            return feed_char(p, c);
+        }
+        if (p->len >= CFG_JSON_TOKEN_MAX - 1) return -1;
+        buf_put(p, c);
+        return 0;
+    case P_SKIP:
+        if (c == '"') p->state = P_SKIP_STR;
+        else if (c == '{' || c == '[') p->depth++;
+        else if ((c == '}' || c == ']') && !--p->depth) p->state = P_NEXT;
+        return 0;
+    case P_SKIP_STR:
+        if ((r = str_char(p, c, 0)) < 0) return -1;
+        if (r) p->state = P_SKIP;
+        return 0;
+    case P_NEXT:
+        if (IS_WS(c)) return 0;
+        if (c == ',') p->state = P_KEY_NEXT;
+        else if (c == '}') p->state = P_END;
+        else return -1;
+        return 0;
+    case P_END:
+        return IS_WS(c) || c == 0 ? 0 : -1;
+    default:
+        return -1;
+    }
+}
+
+esp_err_t config_json_feed(config_json_parser_t *p, const char *buf, size_t len) {
+    if (p->state == P_ERR)
+        return ESP_FAIL;
+    if (p->total + len > p->max) {
+        ESP_LOGE(TAG, "[%s] input exceeds %u bytes", __func__, (unsigned)p->max);
+        p->state = P_ERR;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (feed_char(p, buf[i])) {
+            ESP_LOGE(TAG, "[%s] bad json at %u", __func__, (unsigned)(p->total + i));
+            p->state = P_ERR;
+            return ESP_FAIL;
+        }
+    }
+    p->total += len;
+    return ESP_OK;
+}
+
+esp_err_t config_json_finish(config_json_parser_t *p) {
+    return p->state == P_END ? ESP_OK : ESP_FAIL;
+}
+
+#define CFG_JSON_KEY_ENTRY(n) [cfg_##n] = { CFG_JSON_KEY(n), sizeof(CFG_JSON_KEY(n)) - 1 },
+
+static const struct {
+    const char *str;
+    uint8_t len;
+} config_json_keys[] = {
+    CFG_CALIBRATION_ITEM_LIST(CFG_JSON_KEY_ENTRY)
+    CFG_GPS_ITEM_LIST(CFG_JSON_KEY_ENTRY)
+    CFG_SCREEN_ITEM_LIST(CFG_JSON_KEY_ENTRY)
+    CFG_SCREEN_ITEM_LIST_A(CFG_JSON_KEY_ENTRY)
+    CFG_FW_UPDATE_ITEM_LIST(CFG_JSON_KEY_ENTRY)
+    CFG_ITEM_LIST(CFG_JSON_KEY_ENTRY)
+};
+
+static char *put_uint(char *p, uint32_t v) {
+    char tmp[10];
+    uint8_t n = 0;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n)
+        *p++ = tmp[--n];
+    return p;
+}
+
+static char *put_str(char *p, const char *s, size_t max) {
+    static const char hex[] = "0123456789abcdef";
+    *p++ = '"';
+    for (const char *e = s + max; s < e && *s; s++) {
+        uint8_t c = *s;
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = c;
+        } else if (c < 0x20) {
+            *p++ = '\\';
+            switch (c) {
+            case '\b': *p++ = 'b'; break;
+            case '\f': *p++ = 'f'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            default:
+                memcpy(p, "u00", 3);
+                p[3] = hex[c >> 4];
+                p[4] = hex[c & 0xf];
+                p += 5;
+                break;
+            }
+        } else {
+            *p++ = c;
+        }
+    }
+    *p++ = '"';
+    return p;
+}
+
+static char *put_value(char *p, const config_field_t *f, const logger_config_t *config) {
+    switch (f->type) {
+    case CFG_T_STR:
+        return put_str(p, (const char *)CFG_FIELD_PTR(f, config), f->size - 1);
+    case CFG_T_FLOAT: {
+        float v = config_field_get_float(f, config);
+        if (!(fabsf(v) < 1e9f)) // nan, inf and out of range values have no place in the file
+            v = 0;
+        return p + snprintf(p, CFG_JSON_FLOAT_MAX, "%.*f", f->prec > 9 ? 9 : f->prec, v);
+    }
+    case CFG_T_INT: {
+        int32_t v = config_field_get_int(f, config);
+        if (v < 0)
+            *p++ = '-';
+        return put_uint(p, v < 0 ? -(uint32_t)v : (uint32_t)v);
+    }
+    default:
+        return put_uint(p, (uint32_t)config_field_get_int(f, config));
+    }
+}
+
+#define CFG_JSON_ITEM_FITS(n) _Static_assert(CFG_JSON_ITEM_MAX(n) <= CFG_JSON_CHUNK, #n " does not fit CFG_JSON_CHUNK");
+CFG_CALIBRATION_ITEM_LIST(CFG_JSON_ITEM_FITS)
+CFG_GPS_ITEM_LIST(CFG_JSON_ITEM_FITS)
+CFG_SCREEN_ITEM_LIST(CFG_JSON_ITEM_FITS)
+CFG_SCREEN_ITEM_LIST_A(CFG_JSON_ITEM_FITS)
+CFG_FW_UPDATE_ITEM_LIST(CFG_JSON_ITEM_FITS)
+CFG_ITEM_LIST(CFG_JSON_ITEM_FITS)
+
+/// runtime twin of CFG_JSON_VAL_MAX
+static size_t value_max(const config_field_t *f) {
+    switch (f->type) {
+    case CFG_T_STR: return 2 + 6 * (f->size - 1);
+    case CFG_T_FLOAT: return CFG_JSON_FLOAT_MAX;
+    case CFG_T_INT: return 11;
+    default: return 10;
+    }
+}
+
+esp_err_t config_json_stream(const logger_config_t *config, config_change_mask_t items, uint8_t ublox_hw, config_sink_t sink, void *ctx) {
+    int64_t start = config_metric_start();
+    char buf[CFG_JSON_CHUNK], *p = buf, *end = buf + sizeof(buf);
+    esp_err_t ret = ESP_FAIL;
+    *p++ = '{';
+    for (size_t i = 0, n = 0; i < config_item_count; i++) {
+        const config_field_t *f = &config_fields[i];
+        if (!(items & (1ULL << i)) || config_field_hidden(f, config, ublox_hw))
+            continue;
+        if (p + config_json_keys[i].len + value_max(f) > end) {
+            if (sink(ctx, buf, p - buf))
+                goto done;
+            p = buf;
+        }
+        // first key chunk without its leading comma
+        uint8_t skip = n++ ? 0 : 1;
+        memcpy(p, config_json_keys[i].str + skip, config_json_keys[i].len - skip);
+        p += config_json_keys[i].len - skip;
+        p = put_value(p, f, config);
+    }
+    if (p + 3 > end) {
+        if (sink(ctx, buf, p - buf))
+            goto done;
+        p = buf;
+    }
+    memcpy(p, "\n}\n", 3);
+    p += 3;
+    if (!sink(ctx, buf, p - buf))
+        ret = ESP_OK;
+done:
+    config_metric_end(cfg_metric_encode, start);
+    return ret;
+}
@@ -0,0 +1,69 @@
+#ifndef D5E1C0B4_3A8F_4E21_B7C9_6F0A2E9D1B37
+#define D5E1C0B4_3A8F_4E21_B7C9_6F0A2E9D1B37
+
+#include <stdint.h>
+#include <stddef.h>
+#include "logger_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(CONFIG_LOGGER_CONFIG_JSON_MAX_SIZE)
+#define CONFIG_LOGGER_CONFIG_JSON_MAX_SIZE 4096
+#endif
+
+#define CFG_JSON_TOKEN_MAX 64
+
+/// push parser state, config object is walked once and values go straight to their fields
+typedef struct config_json_parser_s {
+    logger_config_t *config;
+    uint64_t done;     // items already set by canonical name
+    uint64_t changed;  // items whose value changed
+    size_t total;      // bytes fed so far
+    size_t max;        // input size cap
+    int16_t item;      // item of current key, -1 when unknown
+    uint8_t alias;     // current key is a legacy spelling
+    uint8_t state;
+    uint8_t depth;     // nesting depth of skipped value
+    uint8_t esc;       // escape sequence progress in string
+    uint16_t ucode;    // \u escape code point
+    uint8_t len;       // bytes in buf
+    char buf[CFG_JSON_TOKEN_MAX];
+} config_json_parser_t;
+
+void config_json_parser_init(config_json_parser_t *p, logger_config_t *config, size_t max);
+
+/// feed next chunk, ESP_OK while input is valid so far
+esp_err_t config_json_feed(config_json_parser_t *p, const char *buf, size_t len);
+
+/// ESP_OK when a complete object was parsed
+esp_err_t config_json_finish(config_json_parser_t *p);
+
+/// constant chunk written before each value of the saved file
+#define CFG_JSON_KEY(n) ",\n\"" #n "\":"
+
+/// widest text of one value, strings with every byte escaped as \u00XX
+#define CFG_JSON_FLOAT_MAX 24
+#define CFG_JSON_VAL_MAX_UINT(s) 10
+#define CFG_JSON_VAL_MAX_BITS(s) 10
+#define CFG_JSON_VAL_MAX_BOOL(s) 10
+#define CFG_JSON_VAL_MAX_FLAG(s) 10
+#define CFG_JSON_VAL_MAX_INT(s) 11
+#define CFG_JSON_VAL_MAX_FLOAT(s) CFG_JSON_FLOAT_MAX
+#define CFG_JSON_VAL_MAX_STR(s) (2 + 6 * ((s) - 1))
+#define CFG_JSON_VAL_MAX(...) CFG_JSON_VAL_MAX_I(__VA_ARGS__)
+#define CFG_JSON_VAL_MAX_I(member, kind) CFG_JSON_VAL_MAX_##kind(sizeof(((logger_config_t *)0)->member))
+#define CFG_JSON_ITEM_MAX(n) ((sizeof(CFG_JSON_KEY(n)) - 1) + CFG_JSON_VAL_MAX(CFG_FIELD_##n))
+
+/// stack buffer of config_json_stream, every single item fits
+#define CFG_JSON_CHUNK 256
+
+/// encode the config file text of the items in mask in pieces of at most CFG_JSON_CHUNK bytes
+esp_err_t config_json_stream(const logger_config_t *config, config_change_mask_t items, uint8_t ublox_hw, config_sink_t sink, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* D5E1C0B4_3A8F_4E21_B7C9_6F0A2E9D1B37 */
@@ -0,0 +1,121 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+
+static const char *TAG = "config_lock";
+
+// misc takes whatever is left, so every item has exactly one section
+static const config_change_mask_t config_lock_section_items[] = { CFG_GPS_ITEMS_MASK, CFG_SCREEN_ITEMS_MASK, CFG_FW_UPDATE_ITEMS_MASK, CFG_WIFI_ITEMS_MASK };
+_Static_assert(lengthof(config_lock_section_items) == cfg_lock_misc, "section masks out of CFG_LOCK_SECTION_LIST order");
+_Static_assert(cfg_metric_hold_store - cfg_metric_hold_gps == cfg_lock_store, "hold metrics out of CFG_LOCK_SECTION_LIST order");
+
+static SemaphoreHandle_t config_locks[cfg_lock_count];
+// only touched by the task holding the lock
+static uint8_t config_lock_depth[cfg_lock_count];
+static int64_t config_lock_since[cfg_lock_count];
+
+void config_lock_init(void) {
+    for (uint8_t i = 0; i < cfg_lock_count; i++) {
+        if (!config_locks[i])
+            config_locks[i] = xSemaphoreCreateRecursiveMutex();
+    }
+}
+
+void config_lock_deinit(void) {
+    for (uint8_t i = 0; i < cfg_lock_count; i++) {
+        if (config_locks[i]) {
+            vSemaphoreDelete(config_locks[i]);
+            config_locks[i] = 0;
+        }
+    }
+}
+
+int config_lock_ready(void) {
+    return config_locks[cfg_lock_store] != 0;
+}
+
+static inline uint8_t config_lock_sections(config_change_mask_t items) {
+    uint8_t sections = 0;
+    config_change_mask_t rest = items;
+    for (uint8_t i = 0; i < cfg_lock_misc; i++) {
+        if (items & config_lock_section_items[i])
+            sections |= 1 << i;
+        rest &= ~config_lock_section_items[i];
+    }
+    if (rest)
+        sections |= 1 << cfg_lock_misc;
+    return sections;
+}
+
+static void config_lock_take(config_lock_id_t lock, const char *op) {
+    int64_t start = config_metric_start();
+    xSemaphoreTakeRecursive(config_locks[lock], portMAX_DELAY);
+    if (config_lock_depth[lock]++)
+        return; // nested take, wait and hold belong to the outermost one
+    config_lock_since[lock] = esp_timer_get_time();
+    config_metric_end(cfg_metric_lock_wait, start);
+#if defined(CONFIG_LOGGER_CONFIG_LOCK_TRACE)
+    config_trace_acquired(lock, op, start);
+#else
+    (void)op;
+#endif
+}
+
+static void config_lock_give(config_lock_id_t lock) {
+    if (!--config_lock_depth[lock]) {
+        config_metric_end(cfg_metric_hold_gps + lock, config_lock_since[lock]);
+#if defined(CONFIG_LOGGER_CONFIG_LOCK_TRACE)
+        config_trace_released(lock);
+#endif
+    }
+    xSemaphoreGiveRecursive(config_locks[lock]);
+}
+
+void config_lock_items(const char *op, config_change_mask_t items) {
+    uint8_t sections = config_lock_sections(items);
+    for (uint8_t i = 0; i < cfg_lock_store; i++) {
+        if (sections & (1 << i))
+            config_lock_take(i, op);
+    }
+}
+
+void config_unlock_items(config_change_mask_t items) {
+    uint8_t sections = config_lock_sections(items);
+    for (uint8_t i = cfg_lock_store; i-- > 0;) {
+        if (sections & (1 << i))
+            config_lock_give(i);
+    }
+}
+
+void config_lock(const char *op) {
+    config_lock_items(op, ~0ULL);
+}
+
+void config_unlock(void) {
+    config_unlock_items(~0ULL);
+}
+
+void config_store_lock(const char *op) {
+    // store before sections, taking it the other way round can deadlock against a saving task
+    if (xSemaphoreGetMutexHolder(config_locks[cfg_lock_store]) != xTaskGetCurrentTaskHandle() && config_lock_held())
+        ESP_LOGE(TAG, "[%s] store lock taken inside a section lock by %s", __func__, op);
+    config_lock_take(cfg_lock_store, op);
+}
+
+void config_store_unlock(void) {
+    config_lock_give(cfg_lock_store);
+}
+
+int config_lock_held(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < cfg_lock_store; i++) {
+        if (config_locks[i] && xSemaphoreGetMutexHolder(config_locks[i]) == self)
+            return 1;
+    }
+    return 0;
+}
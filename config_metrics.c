@@ -0,0 +1,105 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_timer.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "strbf.h"
+
+#define CFG_METRIC_NAME(n) #n,
+
+static const char * const config_metric_names[] = { CFG_METRIC_LIST(CFG_METRIC_NAME) };
+static const char * const config_save_trigger_names[] = { CFG_SAVE_TRIGGER_LIST(CFG_METRIC_NAME) };
+
+/// upper bound of each histogram bucket, the last one takes the rest
+static const uint32_t config_metric_bounds[CFG_METRIC_BUCKETS - 1] = {100, 300, 1000, 3000, 10000, 30000, 100000};
+
+static config_metrics_t config_metrics;
+static portMUX_TYPE config_metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void config_metric_end(config_metric_t m, int64_t start) {
+    int64_t d = esp_timer_get_time() - start;
+    uint32_t us = d < 0 ? 0 : d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+    uint8_t b = 0;
+    while (b < CFG_METRIC_BUCKETS - 1 && us >= config_metric_bounds[b])
+        b++;
+    config_metric_timing_t *t = &config_metrics.timing[m];
+    portENTER_CRITICAL(&config_metrics_mux);
+    t->count++;
+    t->total_us += us;
+    if (us > t->max_us)
+        t->max_us = us;
+    t->hist[b]++;
+    portEXIT_CRITICAL(&config_metrics_mux);
+}
+
+void config_metric_bytes(size_t read, size_t written) {
+    portENTER_CRITICAL(&config_metrics_mux);
+    config_metrics.bytes_read += read;
+    config_metrics.bytes_written += written;
+    portEXIT_CRITICAL(&config_metrics_mux);
+}
+
+void config_metric_save(config_save_trigger_t trigger) {
+    portENTER_CRITICAL(&config_metrics_mux);
+    config_metrics.saves[trigger]++;
+    portEXIT_CRITICAL(&config_metrics_mux);
+}
+
+void config_metrics_get(config_metrics_t *metrics, uint8_t reset) {
+    portENTER_CRITICAL(&config_metrics_mux);
+    if (metrics)
+        *metrics = config_metrics;
+    if (reset)
+        memset(&config_metrics, 0, sizeof(config_metrics));
+    portEXIT_CRITICAL(&config_metrics_mux);
+}
+
+void config_put_u64(strbf_t *sb, uint64_t v) {
+    char buf[21]; // strbf_putul takes an unsigned long, 32 bits on the chip
+    snprintf(buf, sizeof(buf), "%" PRIu64, v);
+    strbf_puts(sb, buf);
+}
+
+char *config_metrics_json(strbf_t *sb, uint8_t reset) {
+    config_metrics_t m;
+    config_metrics_get(&m, reset);
+    strbf_putc(sb, '{');
+    for (uint8_t i = 0; i < cfg_metric_count; i++) {
+        const config_metric_timing_t *t = &m.timing[i];
+        strbf_putc(sb, '"');
+        strbf_puts(sb, config_metric_names[i]);
+        strbf_puts(sb, "\":{\"count\":");
+        strbf_putul(sb, t->count);
+        strbf_puts(sb, ",\"total_us\":");
+        config_put_u64(sb, t->total_us);
+        strbf_puts(sb, ",\"max_us\":");
+        strbf_putul(sb, t->max_us);
+        strbf_puts(sb, ",\"hist\":[");
+        for (uint8_t b = 0; b < CFG_METRIC_BUCKETS; b++) {
+            if (b)
+                strbf_putc(sb, ',');
+            strbf_putul(sb, t->hist[b]);
+        }
+        strbf_puts(sb, "]},");
+    }
+    strbf_puts(sb, "\"bytes_read\":");
+    config_put_u64(sb, m.bytes_read);
+    strbf_puts(sb, ",\"bytes_written\":");
+    config_put_u64(sb, m.bytes_written);
+    strbf_puts(sb, ",\"saves\":{");
+    for (uint8_t i = 0; i < cfg_save_trigger_count; i++) {
+        if (i)
+            strbf_putc(sb, ',');
+        strbf_putc(sb, '"');
+        strbf_puts(sb, config_save_trigger_names[i]);
+        strbf_puts(sb, "\":");
+        strbf_putul(sb, m.saves[i]);
+    }
+    strbf_puts(sb, "}}");
+    return strbf_finish(sb);
+}
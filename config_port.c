@@ -0,0 +1,296 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "config_port.h"
+
+#include "logger_config_private.h"
+
+#if defined(CONFIG_LOGGER_CONFIG_STORAGE_SIM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#endif
+
+#if defined(CONFIG_IDF_TARGET_LINUX)
+
+#if !defined(CONFIG_LOGGER_CONFIG_HOST_DIR)
+#define CONFIG_LOGGER_CONFIG_HOST_DIR "."
+#endif
+
+const char *config_port_dir(void) {
+    return CONFIG_LOGGER_CONFIG_HOST_DIR;
+}
+
+static int port_write(const char *path, uint8_t append, const void *buf, size_t len) {
+    config_metric_bytes(0, len);
+    FILE *fd = fopen(path, append ? "ab" : "wb");
+    if (!fd)
+        return -1;
+    size_t n = fwrite(buf, 1, len, fd);
+    return (fclose(fd) || n != len) ? -1 : 0;
+}
+
+static int port_rename(const char *from, const char *to) {
+    remove(to);
+    return rename(from, to);
+}
+
+// key-value stand-in, one small file per key
+#define PORT_KV_PATH_MAX 64
+
+static const char *port_kv_path(const char *key, char *buf) {
+    snprintf(buf, PORT_KV_PATH_MAX, "%s/kv_%s", CONFIG_LOGGER_CONFIG_HOST_DIR, key);
+    return buf;
+}
+
+int config_port_kv_get(const char *key, void *buf, size_t max) {
+    char path[PORT_KV_PATH_MAX];
+    FILE *fd = fopen(port_kv_path(key, path), "rb");
+    if (!fd)
+        return -1;
+    size_t n = fread(buf, 1, max, fd);
+    fclose(fd);
+    config_metric_bytes(n, 0);
+    return n;
+}
+
+int config_port_kv_set(const char *key, const void *buf, size_t len) {
+    char path[PORT_KV_PATH_MAX];
+    return config_port_write(port_kv_path(key, path), 0, buf, len);
+}
+
+int config_port_kv_erase(const char *key) {
+    char path[PORT_KV_PATH_MAX];
+    return (remove(port_kv_path(key, path)) && errno != ENOENT) ? -1 : 0;
+}
+
+int config_port_kv_commit(void) {
+    return 0;
+}
+
+#else
+
+#include "nvs.h"
+#include "vfs.h"
+#include "vfs_fat_sdspi.h"
+#if defined(CONFIG_USE_FATFS)
+#include "vfs_fat_spiflash.h"
+#endif
+
+const char *config_port_dir(void) {
+    if (sdcard_is_mounted())
+        return CONFIG_SD_MOUNT_POINT;
+#if defined(CONFIG_USE_FATFS)
+    if (fatfs_is_mounted()) // first choice is internal fat partition
+        return CONFIG_FATFS_MOUNT_POINT;
+#endif
+#if defined(CONFIG_USE_LITTLEFS)
+    if (littlefs_is_mounted())
+        return CONFIG_LITTLEFS_MOUNT_POINT;
+#endif
+    return 0;
+}
+
+static int port_write(const char *path, uint8_t append, const void *buf, size_t len) {
+    config_metric_bytes(0, len);
+    return s_write(path, append, buf, len);
+}
+
+static int port_rename(const char *from, const char *to) {
+    return s_rename_file_n(from, to, 1);
+}
+
+#define PORT_KV_NAMESPACE "logger_cfg"
+
+static nvs_handle_t port_kv_handle;
+static uint8_t port_kv_opened = 0;
+
+/// nvs_flash_init is done by the application
+static int port_kv_open(void) {
+    if (!port_kv_opened && nvs_open(PORT_KV_NAMESPACE, NVS_READWRITE, &port_kv_handle) == ESP_OK)
+        port_kv_opened = 1;
+    return port_kv_opened ? 0 : -1;
+}
+
+int config_port_kv_get(const char *key, void *buf, size_t max) {
+    size_t len = max;
+    if (port_kv_open() || nvs_get_blob(port_kv_handle, key, buf, &len) != ESP_OK)
+        return -1;
+    config_metric_bytes(len, 0);
+    return len;
+}
+
+int config_port_kv_set(const char *key, const void *buf, size_t len) {
+    if (port_kv_open() || nvs_set_blob(port_kv_handle, key, buf, len) != ESP_OK)
+        return -1;
+    config_metric_bytes(0, len);
+    return 0;
+}
+
+int config_port_kv_erase(const char *key) {
+    if (port_kv_open())
+        return -1;
+    esp_err_t ret = nvs_erase_key(port_kv_handle, key);
+    return (ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND) ? 0 : -1;
+}
+
+int config_port_kv_commit(void) {
+    if (port_kv_open() || nvs_commit(port_kv_handle) != ESP_OK)
+        return -1;
+    return 0;
+}
+
+#endif
+
+// streamed files go through stdio on every target, the vfs helpers only take whole buffers
+static void *port_open(const char *path) {
+    return fopen(path, "wb");
+}
+
+static int port_put(void *fd, const void *buf, size_t len) {
+    config_metric_bytes(0, len);
+    return fwrite(buf, 1, len, fd) == len ? 0 : -1;
+}
+
+static int port_close(void *fd) {
+    return fclose(fd) ? -1 : 0;
+}
+
+#if defined(CONFIG_LOGGER_CONFIG_STORAGE_SIM)
+
+#define SIM_OPEN 0x01
+#define SIM_WRITE 0x02
+#define SIM_SYNC 0x04
+#define SIM_RENAME 0x08
+
+static config_storage_profile_t sim_profile;
+static config_storage_stats_t sim_stats;
+static portMUX_TYPE sim_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void config_storage_sim_set(const config_storage_profile_t *profile) {
+    portENTER_CRITICAL(&sim_mux);
+    if (profile)
+        sim_profile = *profile;
+    else
+        memset(&sim_profile, 0, sizeof(sim_profile));
+    portEXIT_CRITICAL(&sim_mux);
+}
+
+void config_storage_stats(config_storage_stats_t *stats, uint8_t reset) {
+    portENTER_CRITICAL(&sim_mux);
+    if (stats)
+        *stats = sim_stats;
+    if (reset)
+        memset(&sim_stats, 0, sizeof(sim_stats));
+    portEXIT_CRITICAL(&sim_mux);
+}
+
+/// block the caller like a busy card would, rounded up to whole ticks
+static void sim_delay(uint8_t ops, size_t bytes) {
+    config_storage_profile_t p;
+    portENTER_CRITICAL(&sim_mux);
+    p = sim_profile;
+    portEXIT_CRITICAL(&sim_mux);
+    uint32_t us = 0;
+    if (ops & SIM_OPEN)
+        us += p.open_us;
+    if (ops & SIM_WRITE)
+        us += p.write_us;
+    if (ops & SIM_SYNC)
+        us += p.fsync_us;
+    if (ops & SIM_RENAME)
+        us += p.rename_us;
+    if (bytes && p.bytes_per_ms)
+        us += (uint32_t)((uint64_t)bytes * 1000 / p.bytes_per_ms);
+    if (p.jitter_us)
+        us += esp_random() % (p.jitter_us + 1);
+    if (!us)
+        return;
+    TickType_t ticks = pdMS_TO_TICKS((us + 999) / 1000);
+    vTaskDelay(ticks ? ticks : 1);
+}
+
+static void sim_account(int64_t start, size_t bytes) {
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    uint8_t locked = config_lock_held(); // storage stalling a section, the store lock alone blocks no reader
+    portENTER_CRITICAL(&sim_mux);
+    sim_stats.ops++;
+    sim_stats.bytes += bytes;
+    sim_stats.io_us += us;
+    if (us > sim_stats.io_max_us)
+        sim_stats.io_max_us = us;
+    if (locked) {
+        sim_stats.locked_us += us;
+        if (us > sim_stats.locked_max_us)
+            sim_stats.locked_max_us = us;
+    }
+    portEXIT_CRITICAL(&sim_mux);
+}
+
+int config_port_write(const char *path, uint8_t append, const void *buf, size_t len) {
+    int64_t start = esp_timer_get_time();
+    sim_delay(SIM_OPEN | SIM_WRITE | SIM_SYNC, len);
+    int ret = port_write(path, append, buf, len);
+    sim_account(start, len);
+    return ret;
+}
+
+int config_port_rename(const char *from, const char *to) {
+    int64_t start = esp_timer_get_time();
+    sim_delay(SIM_RENAME, 0);
+    int ret = port_rename(from, to);
+    sim_account(start, 0);
+    return ret;
+}
+
+void *config_port_open(const char *path) {
+    int64_t start = esp_timer_get_time();
+    sim_delay(SIM_OPEN, 0);
+    void *fd = port_open(path);
+    sim_account(start, 0);
+    return fd;
+}
+
+int config_port_put(void *fd, const void *buf, size_t len) {
+    int64_t start = esp_timer_get_time();
+    sim_delay(SIM_WRITE, len);
+    int ret = port_put(fd, buf, len);
+    sim_account(start, len);
+    return ret;
+}
+
+int config_port_close(void *fd) {
+    int64_t start = esp_timer_get_time();
+    sim_delay(SIM_SYNC, 0);
+    int ret = port_close(fd);
+    sim_account(start, 0);
+    return ret;
+}
+
+#else
+
+int config_port_write(const char *path, uint8_t append, const void *buf, size_t len) {
+    return port_write(path, append, buf, len);
+}
+
+int config_port_rename(const char *from, const char *to) {
+    return port_rename(from, to);
+}
+
+void *config_port_open(const char *path) {
+    return port_open(path);
+}
+
+int config_port_put(void *fd, const void *buf, size_t len) {
+    return port_put(fd, buf, len);
+}
+
+int config_port_close(void *fd) {
+    return port_close(fd);
+}
+
+#endif
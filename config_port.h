@@ -0,0 +1,54 @@
+#ifndef C8E5B3A1_0F2D_4B69_9A7E_5D14F6C2E8B3
+#define C8E5B3A1_0F2D_4B69_9A7E_5D14F6C2E8B3
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Storage glue, the only place that knows about mount points, nvs and the logger_vfs helpers.
+ * On the IDF linux target plain stdio in LOGGER_CONFIG_HOST_DIR is used, so the module runs natively on the host.
+ */
+
+/// directory holding the config files, 0 when no filesystem is mounted
+const char *config_port_dir(void);
+
+/// write or append len bytes to path, 0 on success
+int config_port_write(const char *path, uint8_t append, const void *buf, size_t len);
+
+/// replace to with from, 0 on success
+int config_port_rename(const char *from, const char *to);
+
+/// create or truncate path for writing in pieces, 0 on failure
+void *config_port_open(const char *path);
+
+/// write next piece, 0 on success
+int config_port_put(void *fd, const void *buf, size_t len);
+
+/// flush and close, 0 on success
+int config_port_close(void *fd);
+
+/*
+ * Key-value storage for the kv config store, nvs on the device and one file per key on the linux target.
+ */
+
+/// read value of key into buf, returns its length or -1 when not found
+int config_port_kv_get(const char *key, void *buf, size_t max);
+
+/// set value of key, 0 on success
+int config_port_kv_set(const char *key, const void *buf, size_t len);
+
+/// remove key, a missing key is not an error, 0 on success
+int config_port_kv_erase(const char *key);
+
+/// make set and erased values durable, 0 on success
+int config_port_kv_commit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* C8E5B3A1_0F2D_4B69_9A7E_5D14F6C2E8B3 */
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_fields.h"
+#include "config_port.h"
+#include "config_snapshot.h"
+
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+
+static const char *TAG = "config_profile";
+
+#define CFG_PROFILE_MAGIC 0x5046434cU // "LCFP"
+#define CFG_PROFILE_SEL_FILE_NAME "profile.sel"
+#define CFG_PROFILE_PATH_MAX 64
+
+/// the only file written when switching, names live here too
+typedef struct __attribute__((packed)) config_profile_sel_s {
+    uint32_t magic;
+    int8_t active;
+    char name[CONFIG_LOGGER_CONFIG_PROFILES_MAX][CFG_PROFILE_NAME_MAX];
+} config_profile_sel_t;
+
+static config_profile_sel_t config_profile_sel = { .magic = CFG_PROFILE_MAGIC, .active = -1 };
+static logger_config_t config_profiles[CONFIG_LOGGER_CONFIG_PROFILES_MAX]; // preloaded, only profile items are used
+static const char *config_profile_dir = 0;
+static config_change_mask_t config_profile_dirty = 0; // items of the active profile not in its file yet
+
+static const char *config_profile_path(int8_t i, char *buf) {
+    if (i < 0)
+        snprintf(buf, CFG_PROFILE_PATH_MAX, "%s/%s", config_profile_dir, CFG_PROFILE_SEL_FILE_NAME);
+    else
+        snprintf(buf, CFG_PROFILE_PATH_MAX, "%s/profile%d.bin", config_profile_dir, i);
+    return buf;
+}
+
+static esp_err_t config_profile_sel_write(void) {
+    char path[CFG_PROFILE_PATH_MAX];
+    return config_port_write(config_profile_path(-1, path), 0, &config_profile_sel, sizeof(config_profile_sel)) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t config_profile_write(int8_t i) {
+    char path[CFG_PROFILE_PATH_MAX];
+    return config_snapshot_save(&config_profiles[i], CFG_PROFILE_ITEMS_MASK, 0, config_profile_path(i, path), 0, 0);
+}
+
+static void config_profile_copy(logger_config_t *dst, const logger_config_t *src, config_change_mask_t items) {
+    for (; items; items &= items - 1) {
+        const config_field_t *f = &config_fields[__builtin_ctzll(items)];
+        config_field_copy(f, dst, src);
+    }
+}
+
+void config_profile_init(const char *dir) {
+    config_profile_dir = dir;
+}
+
+void config_profile_load(logger_config_t *config, uint8_t stored) {
+    if (!config_profile_dir)
+        return;
+    char path[CFG_PROFILE_PATH_MAX];
+    config_profile_sel_t sel;
+    FILE *fd = fopen(config_profile_path(-1, path), "rb");
+    if (!fd)
+        return;
+    size_t n = fread(&sel, 1, sizeof(sel), fd);
+    fclose(fd);
+    config_metric_bytes(n, 0);
+    if (n != sizeof(sel) || sel.magic != CFG_PROFILE_MAGIC) {
+        ESP_LOGW(TAG, "[%s] bad %s", __func__, path);
+        return;
+    }
+    for (int8_t i = 0; i < CONFIG_LOGGER_CONFIG_PROFILES_MAX; i++) {
+        sel.name[i][CFG_PROFILE_NAME_MAX - 1] = 0;
+        if (!sel.name[i][0])
+            continue;
+        memcpy(&config_profiles[i], config, sizeof(*config));
+        if (config_snapshot_load(&config_profiles[i], config_profile_path(i, path), 0) != ESP_OK) {
+            ESP_LOGW(TAG, "[%s] profile %s lost", __func__, sel.name[i]);
+            sel.name[i][0] = 0;
+        }
+    }
+    if (sel.active >= CONFIG_LOGGER_CONFIG_PROFILES_MAX || (sel.active >= 0 && !sel.name[sel.active][0]))
+        sel.active = -1;
+    memcpy(&config_profile_sel, &sel, sizeof(sel));
+    config_profile_dirty = 0;
+    if (sel.active < 0)
+        return;
+    if (stored) {
+        // the store is ahead of the profile file for edits journaled after its last write
+        config_profile_track(config);
+    } else {
+        config_change_mask_t changed = config_diff(config, &config_profiles[sel.active]) & CFG_PROFILE_ITEMS_MASK;
+        config_profile_copy(config, &config_profiles[sel.active], changed);
+    }
+}
+
+void config_profile_track(const logger_config_t *config) {
+    int8_t i = config_profile_sel.active;
+    if (i < 0)
+        return;
+    // edits made while a profile is active belong to that profile
+    config_change_mask_t changed = config_diff(&config_profiles[i], config) & CFG_PROFILE_ITEMS_MASK;
+    config_profile_copy(&config_profiles[i], config, changed);
+    config_profile_dirty |= changed;
+}
+
+esp_err_t config_profile_sync(void) {
+    int8_t i = config_profile_sel.active;
+    if (i < 0 || !config_profile_dirty)
+        return ESP_OK;
+    esp_err_t ret = config_profile_write(i);
+    if (ret == ESP_OK)
+        config_profile_dirty = 0;
+    return ret;
+}
+
+int config_profile_find(const char *name) {
+    if (!name || !*name)
+        return -1;
+    for (int i = 0; i < CONFIG_LOGGER_CONFIG_PROFILES_MAX; i++) {
+        if (!strncmp(config_profile_sel.name[i], name, CFG_PROFILE_NAME_MAX))
+            return i;
+    }
+    return -1;
+}
+
+int config_profile_active(void) {
+    return config_profile_sel.active;
+}
+
+const char *config_profile_name(int idx) {
+    if (idx < 0 || idx >= CONFIG_LOGGER_CONFIG_PROFILES_MAX || !config_profile_sel.name[idx][0])
+        return 0;
+    return config_profile_sel.name[idx];
+}
+
+int config_profile_save(logger_config_t *config, const char *name) {
+    if (!config || !name || !*name || strlen(name) >= CFG_PROFILE_NAME_MAX || !config_profile_dir)
+        return -1;
+    config_store_lock(__func__);
+    int i = config_profile_find(name);
+    uint8_t added = i < 0;
+    for (int j = 0; i < 0 && j < CONFIG_LOGGER_CONFIG_PROFILES_MAX; j++) {
+        if (!config_profile_sel.name[j][0])
+            i = j;
+    }
+    if (i < 0) {
+        ESP_LOGE(TAG, "[%s] no free profile for %s", __func__, name);
+        goto done;
+    }
+    config_lock(__func__);
+    memcpy(&config_profiles[i], config, sizeof(*config));
+    config_unlock();
+    if (config_profile_write(i) != ESP_OK) {
+        i = -1;
+        goto done;
+    }
+    if (i == config_profile_sel.active)
+        config_profile_dirty = 0;
+    if (added) {
+        strcpy(config_profile_sel.name[i], name);
+        config_profile_sel_write();
+    }
+    ILOG(TAG, "[%s] %s saved as %d", __func__, name, i);
+done:
+    config_store_unlock();
+    return i;
+}
+
+esp_err_t config_profile_select(logger_config_t *config, int idx) {
+    if (!config || !config_profile_name(idx))
+        return ESP_ERR_INVALID_ARG;
+    config_store_lock(__func__);
+    // edits of the profile being left are only in the store so far
+    esp_err_t ret = config_profile_sync();
+    config_lock_items(__func__, CFG_PROFILE_ITEMS_MASK);
+    config_change_mask_t changed = config_diff(config, &config_profiles[idx]) & CFG_PROFILE_ITEMS_MASK;
+    config_profile_copy(config, &config_profiles[idx], changed);
+    config_unlock_items(CFG_PROFILE_ITEMS_MASK);
+    if (config_profile_sel.active != idx) {
+        config_profile_sel.active = idx;
+        config_profile_dirty = 0;
+        if (config_profile_sel_write() != ESP_OK)
+            ret = ESP_FAIL;
+    }
+    // switched items go to the journal, the store stays the one place the config is loaded from
+    if (changed && config_persist_live(config, cfg_save_api) != ESP_OK)
+        ret = ESP_FAIL;
+    config_lock(__func__);
+    config_view_stage(config);
+    config_unlock();
+    config_store_release();
+    esp_err_t pub = config_view_commit();
+    if (ret == ESP_OK)
+        ret = pub;
+    config_notify();
+    ILOG(TAG, "[%s] %s active, %d items changed", __func__, config_profile_sel.name[idx], __builtin_popcountll(changed));
+    return ret;
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_port.h"
+#include "config_fields.h"
+#include "config_snapshot.h"
+
+static const char *TAG = "config_snapshot";
+
+static const uint8_t config_snapshot_items[] = {
+    CFG_CALIBRATION_ITEM_LIST(CFG_ENUM) CFG_GPS_ITEM_LIST(CFG_ENUM) CFG_SCREEN_ITEM_LIST(CFG_ENUM)
+    CFG_SCREEN_ITEM_LIST_A(CFG_ENUM) CFG_FW_UPDATE_ITEM_LIST(CFG_ENUM) CFG_ITEM_LIST(CFG_ENUM)
+};
+// every field is a distinct part of logger_config_t, packed flags share a byte but take one each in a record
+#define CFG_SNAPSHOT_MAX (sizeof(config_snapshot_hdr_t) + lengthof(config_snapshot_items) * (CFG_SNAPSHOT_REC_HDR + 1) + sizeof(logger_config_t))
+
+static uint16_t config_snapshot_ids[lengthof(config_snapshot_items)] = {0};
+static uint8_t config_snapshot_ids_ready = 0;
+
+static void config_snapshot_ids_build(void) {
+    for (uint8_t i = 0; i < lengthof(config_snapshot_items); i++) {
+        uint32_t h = 2166136261u;
+        for (const char *s = config_fields[i].name; *s; s++)
+            h = (h ^ (uint8_t)*s) * 16777619u;
+        config_snapshot_ids[i] = (uint16_t)(h ^ (h >> 16));
+        for (uint8_t j = 0; j < i; j++) {
+            if (config_snapshot_ids[j] == config_snapshot_ids[i])
+                ESP_LOGE(TAG, "[%s] id clash %s / %s", __func__, config_fields[j].name, config_fields[i].name);
+        }
+    }
+    config_snapshot_ids_ready = 1;
+}
+
+uint16_t config_snapshot_field_id(uint8_t item) {
+    if (!config_snapshot_ids_ready)
+        config_snapshot_ids_build();
+    return item < lengthof(config_snapshot_items) ? config_snapshot_ids[item] : 0;
+}
+
+static int config_snapshot_item(uint16_t id) {
+    if (!config_snapshot_ids_ready)
+        config_snapshot_ids_build();
+    for (uint8_t i = 0; i < lengthof(config_snapshot_items); i++) {
+        if (config_snapshot_ids[i] == id)
+            return i;
+    }
+    return -1;
+}
+
+size_t config_snapshot_put_record(const logger_config_t *config, uint8_t item, uint8_t *buf, size_t max) {
+    const config_field_t *f = &config_fields[item];
+    const uint8_t *v = CFG_FIELD_PTR(f, config);
+    uint8_t len = f->size, flag;
+    if (f->type == CFG_T_STR) {
+        len = strnlen((const char *)v, f->size);
+    } else if (f->mask) { // one byte 0 or 1, same record as before flags were packed
+        flag = config_field_get_int(f, config);
+        v = &flag;
+    }
+    if (CFG_SNAPSHOT_REC_HDR + len > max)
+        return 0;
+    uint16_t id = config_snapshot_field_id(item);
+    buf[0] = id & 0xff;
+    buf[1] = id >> 8;
+    buf[2] = len;
+    memcpy(buf + CFG_SNAPSHOT_REC_HDR, v, len);
+    return CFG_SNAPSHOT_REC_HDR + len;
+}
+
+size_t config_snapshot_encode(const logger_config_t *config, config_change_mask_t items, uint32_t text_crc, uint8_t *buf, size_t max) {
+    config_snapshot_hdr_t hdr = { .magic = CFG_SNAPSHOT_MAGIC, .version = CFG_SNAPSHOT_VERSION, .text_crc = text_crc };
+    uint8_t *p = buf + sizeof(hdr), *end = buf + max;
+    if (max < sizeof(hdr))
+        return 0;
+    for (uint8_t i = 0; i < lengthof(config_snapshot_items); i++) {
+        if (!(items & (1ULL << i)))
+            continue;
+        size_t n = config_snapshot_put_record(config, i, p, end - p);
+        if (!n)
+            return 0;
+        p += n;
+        hdr.count++;
+    }
+    hdr.body_len = p - buf - sizeof(hdr);
+    hdr.crc = esp_rom_crc32_le(0, buf + sizeof(hdr), hdr.body_len);
+    memcpy(buf, &hdr, sizeof(hdr));
+    return p - buf;
+}
+
+static void config_snapshot_set(const config_field_t *f, logger_config_t *config, const uint8_t *v, uint8_t len) {
+    if (len == f->size && f->type != CFG_T_STR && !f->mask) {
+        memcpy(CFG_FIELD_PTR(f, config), v, len);
+        return;
+    }
+    switch (f->type) {
+    case CFG_T_STR:
+        config_field_set_str(f, config, (const char *)v, strnlen((const char *)v, len), 1);
+        break;
+    case CFG_T_FLOAT:
+        break; // width change of a float is not a thing we write
+    default: { // packed flag, or integer field that changed width between firmware versions
+        if (!len || len > 4)
+            break;
+        uint32_t u = 0;
+        for (uint8_t i = 0; i < len; i++)
+            u |= (uint32_t)v[i] << (8 * i);
+        double d = u;
+        if (f->type == CFG_T_INT && (v[len - 1] & 0x80))
+            d = (int32_t)(u | (len < 4 ? ~0u << (8 * len) : 0));
+        config_field_set_num(f, config, d, 1);
+        break;
+    }
+    }
+}
+
+int config_snapshot_apply_record(logger_config_t *config, const uint8_t *rec) {
+    int item = config_snapshot_item(rec[0] | (rec[1] << 8));
+    if (item >= 0)
+        config_snapshot_set(&config_fields[item], config, rec + CFG_SNAPSHOT_REC_HDR, rec[2]);
+    return item;
+}
+
+/// header of either version, returns its length or 0 when buf holds no snapshot we know
+static size_t config_snapshot_hdr(config_snapshot_hdr_t *hdr, const uint8_t *buf, size_t len) {
+    if (len < CFG_SNAPSHOT_HDR_V1)
+        return 0;
+    memcpy(hdr, buf, CFG_SNAPSHOT_HDR_V1);
+    if (hdr->magic != CFG_SNAPSHOT_MAGIC || hdr->version > CFG_SNAPSHOT_VERSION) {
+        ESP_LOGE(TAG, "[%s] unknown snapshot %08lx v%u", __func__, (unsigned long)hdr->magic, hdr->version);
+        return 0;
+    }
+    if (hdr->version < 2) {
+        hdr->text_crc = CFG_SNAPSHOT_TEXT_ANY;
+        return CFG_SNAPSHOT_HDR_V1;
+    }
+    if (len < sizeof(*hdr))
+        return 0;
+    memcpy(hdr, buf, sizeof(*hdr));
+    return sizeof(*hdr);
+}
+
+esp_err_t config_snapshot_decode(logger_config_t *config, const uint8_t *buf, size_t len, uint32_t *crc) {
+    config_snapshot_hdr_t hdr;
+    size_t hdr_len = config_snapshot_hdr(&hdr, buf, len);
+    if (!hdr_len)
+        return ESP_ERR_INVALID_VERSION;
+    if (hdr.body_len != len - hdr_len)
+        return ESP_ERR_INVALID_SIZE;
+    const uint8_t *p = buf + hdr_len, *end = p + hdr.body_len;
+    if (esp_rom_crc32_le(0, p, hdr.body_len) != hdr.crc) {
+        ESP_LOGE(TAG, "[%s] crc mismatch", __func__);
+        return ESP_ERR_INVALID_CRC;
+    }
+    // records are checked for bounds before anything is applied
+    for (const uint8_t *q = p; q < end; q += CFG_SNAPSHOT_REC_HDR + q[2]) {
+        if (q + CFG_SNAPSHOT_REC_HDR > end || q + CFG_SNAPSHOT_REC_HDR + q[2] > end)
+            return ESP_ERR_INVALID_SIZE;
+    }
+    for (; p < end; p += CFG_SNAPSHOT_REC_HDR + p[2])
+        config_snapshot_apply_record(config, p);
+    if (crc)
+        *crc = hdr.crc;
+    return ESP_OK;
+}
+
+esp_err_t config_snapshot_save(const logger_config_t *config, config_change_mask_t items, uint32_t text_crc, const char *path, const char *backup, uint32_t *crc) {
+    uint8_t buf[CFG_SNAPSHOT_MAX];
+    size_t len = config_snapshot_encode(config, items, text_crc, buf, sizeof(buf));
+    if (!len || !path)
+        return ESP_FAIL;
+    if (crc)
+        *crc = ((const config_snapshot_hdr_t *)buf)->crc;
+    if (backup)
+        config_port_rename(path, backup);
+    return config_port_write(path, 0, buf, len) ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t config_snapshot_load(logger_config_t *config, const char *path, uint32_t *crc) {
+    if (!path)
+        return ESP_FAIL;
+    FILE *fd = fopen(path, "rb");
+    if (!fd)
+        return ESP_ERR_NOT_FOUND;
+    // one byte extra to notice a file that is larger than any snapshot we write
+    uint8_t buf[CFG_SNAPSHOT_MAX + 1];
+    size_t len = fread(buf, 1, sizeof(buf), fd);
+    fclose(fd);
+    config_metric_bytes(len, 0);
+    if (len > CFG_SNAPSHOT_MAX)
+        return ESP_ERR_INVALID_SIZE;
+    return config_snapshot_decode(config, buf, len, crc);
+}
+
+esp_err_t config_snapshot_text_crc(const char *path, uint32_t *text_crc) {
+    if (!path)
+        return ESP_FAIL;
+    FILE *fd = fopen(path, "rb");
+    if (!fd)
+        return ESP_ERR_NOT_FOUND;
+    uint8_t buf[sizeof(config_snapshot_hdr_t)];
+    size_t len = fread(buf, 1, sizeof(buf), fd);
+    fclose(fd);
+    config_snapshot_hdr_t hdr;
+    if (!config_snapshot_hdr(&hdr, buf, len))
+        return ESP_ERR_INVALID_VERSION;
+    *text_crc = hdr.text_crc;
+    return ESP_OK;
+}
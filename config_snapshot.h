@@ -0,0 +1,60 @@
+#ifndef E7C2A915_4B3D_4C8A_A1F6_93D05B2E7F14
+#define E7C2A915_4B3D_4C8A_A1F6_93D05B2E7F14
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "logger_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CFG_SNAPSHOT_MAGIC 0x4746434cU // "LCFG"
+#define CFG_SNAPSHOT_VERSION 2
+#define CFG_SNAPSHOT_REC_HDR 3 // uint16 id + uint8 len
+
+/// file header, body is a list of {uint16 id, uint8 len, value[len]} records
+typedef struct __attribute__((packed)) config_snapshot_hdr_s {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;    // records in body
+    uint32_t body_len;
+    uint32_t crc;      // crc32 of body
+    uint32_t text_crc; // v2: crc32 of the config.txt this snapshot was written or imported with
+} config_snapshot_hdr_t;
+
+#define CFG_SNAPSHOT_HDR_V1 offsetof(config_snapshot_hdr_t, text_crc)
+#define CFG_SNAPSHOT_TEXT_ANY 0xffffffffU // v1 snapshot, written before the text crc was kept
+
+/// stable record id of a field, derived from its name so ids survive item list changes
+uint16_t config_snapshot_field_id(uint8_t item);
+
+/// write record of one item into buf, returns bytes used or 0 when buf is too small
+size_t config_snapshot_put_record(const logger_config_t *config, uint8_t item, uint8_t *buf, size_t max);
+
+/// apply one bounds checked record to config, returns its item or -1 when the id is unknown
+int config_snapshot_apply_record(logger_config_t *config, const uint8_t *rec);
+
+#define CFG_SNAPSHOT_ALL_ITEMS (~0ULL)
+
+/// encode the items of config into buf, returns bytes used or 0 when buf is too small
+size_t config_snapshot_encode(const logger_config_t *config, config_change_mask_t items, uint32_t text_crc, uint8_t *buf, size_t max);
+
+/// decode snapshot in buf into config, unknown records are skipped, *crc set to the body crc
+esp_err_t config_snapshot_decode(logger_config_t *config, const uint8_t *buf, size_t len, uint32_t *crc);
+
+/// write snapshot of the items of config to path, previous file kept as backup, *crc set to the body crc
+esp_err_t config_snapshot_save(const logger_config_t *config, config_change_mask_t items, uint32_t text_crc, const char *path, const char *backup, uint32_t *crc);
+
+/// load snapshot from path with a single read into a stack buffer
+esp_err_t config_snapshot_load(logger_config_t *config, const char *path, uint32_t *crc);
+
+/// text crc recorded in the snapshot header at path, CFG_SNAPSHOT_TEXT_ANY for a v1 snapshot
+esp_err_t config_snapshot_text_crc(const char *path, uint32_t *text_crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* E7C2A915_4B3D_4C8A_A1F6_93D05B2E7F14 */
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_fields.h"
+#include "config_port.h"
+#include "config_snapshot.h"
+
+static const char *TAG = "config_store";
+
+static void config_store_copy(logger_config_t *dst, const logger_config_t *src, config_change_mask_t items) {
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        if (!(items & (1ULL << i)))
+            continue;
+        const config_field_t *f = &config_fields[i];
+        config_field_copy(f, dst, src);
+    }
+}
+
+/// ram store, lost on reset, for tests and benchmarks without storage cost
+
+static logger_config_t config_ram;
+static uint8_t config_ram_valid = 0;
+
+static esp_err_t config_ram_load(logger_config_t *config) {
+    if (!config_ram_valid)
+        return ESP_ERR_NOT_FOUND;
+    config_store_copy(config, &config_ram, CFG_SNAPSHOT_ALL_ITEMS);
+    return ESP_OK;
+}
+
+static esp_err_t config_ram_store(const logger_config_t *config, uint8_t ublox_hw) {
+    config_store_copy(&config_ram, config, CFG_SNAPSHOT_ALL_ITEMS);
+    config_ram_valid = 1;
+    return ESP_OK;
+}
+
+static esp_err_t config_ram_store_field(const logger_config_t *config, uint8_t item) {
+    if (!config_ram_valid)
+        return ESP_ERR_INVALID_STATE;
+    config_store_copy(&config_ram, config, 1ULL << item);
+    return ESP_OK;
+}
+
+const config_store_t config_store_ram = {
+    .name = "ram",
+    .load = config_ram_load,
+    .store = config_ram_store,
+    .store_field = config_ram_store_field,
+};
+
+/// kv store, one snapshot record per item keyed by its stable id, only overridden items have a key, only changes are written
+
+#define CFG_KV_KEY_MAX 8
+#define CFG_KV_REC_MAX (CFG_SNAPSHOT_REC_HDR + UINT8_MAX)
+
+static logger_config_t config_kv_stored; // what the store holds, to write only what differs
+static config_change_mask_t config_kv_present = 0; // items with a key in the store
+
+static const char *config_kv_key(uint8_t item, char *key) {
+    snprintf(key, CFG_KV_KEY_MAX, "f%04x", config_snapshot_field_id(item));
+    return key;
+}
+
+static esp_err_t config_kv_load(logger_config_t *config) {
+    char key[CFG_KV_KEY_MAX];
+    uint8_t rec[CFG_KV_REC_MAX];
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        int len = config_port_kv_get(config_kv_key(i, key), rec, sizeof(rec));
+        if (len < CFG_SNAPSHOT_REC_HDR || len != CFG_SNAPSHOT_REC_HDR + rec[2]) {
+            if (len >= 0)
+                ESP_LOGW(TAG, "[%s] bad value for %s", __func__, config_fields[i].name);
+            continue;
+        }
+        config_snapshot_apply_record(config, rec);
+        config_kv_present |= 1ULL << i;
+    }
+    memcpy(&config_kv_stored, config, sizeof(config_kv_stored));
+    // a config saved at all defaults has no keys and reads as nothing stored, the next save then writes no key either
+    return config_kv_present ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/// write the item when overridden, erase its key when back at the default so a later default change reaches it
+static esp_err_t config_kv_put(const logger_config_t *config, uint8_t item, uint8_t overridden) {
+    char key[CFG_KV_KEY_MAX];
+    uint8_t rec[CFG_KV_REC_MAX];
+    if (overridden) {
+        size_t len = config_snapshot_put_record(config, item, rec, sizeof(rec));
+        if (!len || config_port_kv_set(config_kv_key(item, key), rec, len))
+            return ESP_FAIL;
+        config_kv_present |= 1ULL << item;
+    } else {
+        if (config_port_kv_erase(config_kv_key(item, key)))
+            return ESP_FAIL;
+        config_kv_present &= ~(1ULL << item);
+    }
+    config_store_copy(&config_kv_stored, config, 1ULL << item);
+    return ESP_OK;
+}
+
+static esp_err_t config_kv_store_field(const logger_config_t *config, uint8_t item) {
+    return config_kv_put(config, item, (config_overrides(config) >> item) & 1);
+}
+
+static esp_err_t config_kv_store(const logger_config_t *config, uint8_t ublox_hw) {
+    config_change_mask_t overrides = config_overrides(config);
+    // overrides not stored yet or changed, and keys of items that went back to the default
+    config_change_mask_t items = (overrides & (config_diff(&config_kv_stored, config) | ~config_kv_present)) | (config_kv_present & ~overrides);
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        if ((items & (1ULL << i)) && config_kv_put(config, i, (overrides >> i) & 1) != ESP_OK)
+            return ESP_FAIL;
+    }
+    return config_port_kv_commit() ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t config_kv_sync(void) {
+    return config_port_kv_commit() ? ESP_FAIL : ESP_OK;
+}
+
+const config_store_t config_store_kv = {
+    .name = "kv",
+    .load = config_kv_load,
+    .store = config_kv_store,
+    .store_field = config_kv_store_field,
+    .sync = config_kv_sync,
+};
@@ -0,0 +1,85 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+
+static const char *TAG = "config_subscribe";
+
+#if !defined(CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX)
+#define CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX 8
+#endif
+
+typedef struct config_subscriber_s {
+    config_change_mask_t mask;
+    config_subscriber_cb_t cb;
+    void *ctx;
+} config_subscriber_t;
+
+static config_subscriber_t config_subscribers[CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX] = {0};
+static _Atomic config_change_mask_t config_notify_pending = 0;
+static SemaphoreHandle_t config_notify_lock = 0; // subscriber table
+
+static inline void config_notify_lock_init(void) {
+    if (!config_notify_lock)
+        config_notify_lock = xSemaphoreCreateMutex();
+}
+
+int config_subscribe(config_change_mask_t mask, config_subscriber_cb_t cb, void *ctx) {
+    if (!cb || !mask)
+        return -1;
+    config_notify_lock_init();
+    int ret = -1;
+    xSemaphoreTake(config_notify_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX; i++) {
+        if (!config_subscribers[i].cb) {
+            config_subscribers[i] = (config_subscriber_t){ .mask = mask, .cb = cb, .ctx = ctx };
+            ret = i;
+            break;
+        }
+    }
+    xSemaphoreGive(config_notify_lock);
+    if (ret < 0)
+        ESP_LOGE(TAG, "[%s] no free slot", __func__);
+    return ret;
+}
+
+void config_unsubscribe(int handle) {
+    if (handle < 0 || handle >= CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX || !config_notify_lock)
+        return;
+    xSemaphoreTake(config_notify_lock, portMAX_DELAY);
+    memset(&config_subscribers[handle], 0, sizeof(config_subscriber_t));
+    xSemaphoreGive(config_notify_lock);
+}
+
+void config_notify_mark(config_change_mask_t changed) {
+    atomic_fetch_or(&config_notify_pending, changed);
+}
+
+void config_notify(void) {
+    // inside a nested call the outermost one dispatches after giving its locks
+    if (config_lock_held())
+        return;
+    if (!atomic_load(&config_notify_pending))
+        return;
+    // callbacks run on a copy of the table, so they may subscribe or unsubscribe themselves
+    config_subscriber_t subs[CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX];
+    config_notify_lock_init();
+    xSemaphoreTake(config_notify_lock, portMAX_DELAY);
+    memcpy(subs, config_subscribers, sizeof(subs));
+    xSemaphoreGive(config_notify_lock);
+    config_change_mask_t changed = atomic_exchange(&config_notify_pending, 0);
+    const logger_config_t *view = config_view_acquire(0);
+    for (int i = 0; changed && view && i < CONFIG_LOGGER_CONFIG_SUBSCRIBERS_MAX; i++) {
+        if (subs[i].cb && (subs[i].mask & changed))
+            subs[i].cb(subs[i].mask & changed, view, subs[i].ctx);
+    }
+    config_view_release(view);
+}
@@ -0,0 +1,104 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "strbf.h"
+
+#if defined(CONFIG_LOGGER_CONFIG_LOCK_TRACE)
+
+#define CFG_TRACE_TASK_NAME 16
+
+typedef struct config_trace_rec_s {
+    const char *op;
+    int64_t start;    // us when the caller asked for the lock
+    uint32_t wait_us;
+    uint32_t hold_us;
+    uint32_t tid;
+    uint8_t lock;     // config_lock_id_t
+    char task[CFG_TRACE_TASK_NAME];
+} config_trace_rec_t;
+
+#define CFG_LOCK_NAME(l) #l,
+static const char * const config_trace_lock_names[] = { CFG_LOCK_SECTION_LIST(CFG_LOCK_NAME) "store" };
+
+// the ring is shared by all locks, a record in flight belongs to the holder of its lock
+static config_trace_rec_t config_trace_ring[CONFIG_LOGGER_CONFIG_LOCK_TRACE_SIZE];
+static uint32_t config_trace_head;
+static portMUX_TYPE config_trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static config_trace_rec_t config_trace_cur[cfg_lock_count];
+static int64_t config_trace_acquired_at[cfg_lock_count];
+
+/// outermost take only, nesting is resolved by the caller
+void config_trace_acquired(config_lock_id_t lock, const char *op, int64_t start) {
+    int64_t now = esp_timer_get_time();
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    config_trace_rec_t *cur = &config_trace_cur[lock];
+    cur->op = op;
+    cur->start = start;
+    cur->wait_us = now - start;
+    cur->tid = (uint32_t)(uintptr_t)task;
+    cur->lock = lock;
+    strncpy(cur->task, pcTaskGetName(task), CFG_TRACE_TASK_NAME - 1);
+    cur->task[CFG_TRACE_TASK_NAME - 1] = 0;
+    config_trace_acquired_at[lock] = now;
+}
+
+void config_trace_released(config_lock_id_t lock) {
+    config_trace_cur[lock].hold_us = esp_timer_get_time() - config_trace_acquired_at[lock];
+    portENTER_CRITICAL(&config_trace_mux);
+    config_trace_ring[config_trace_head++ % CONFIG_LOGGER_CONFIG_LOCK_TRACE_SIZE] = config_trace_cur[lock];
+    portEXIT_CRITICAL(&config_trace_mux);
+}
+
+static void config_trace_put_event(strbf_t *sb, const config_trace_rec_t *r, const char *cat, int64_t ts, uint32_t dur) {
+    strbf_puts(sb, "{\"name\":\"");
+    strbf_puts(sb, r->op);
+    strbf_puts(sb, "\",\"cat\":\"");
+    strbf_puts(sb, cat);
+    strbf_puts(sb, "\",\"ph\":\"X\",\"pid\":0,\"tid\":");
+    strbf_putul(sb, r->tid);
+    strbf_puts(sb, ",\"ts\":");
+    config_put_u64(sb, (uint64_t)ts);
+    strbf_puts(sb, ",\"dur\":");
+    strbf_putul(sb, dur);
+    strbf_puts(sb, ",\"args\":{\"lock\":\"");
+    strbf_puts(sb, config_trace_lock_names[r->lock]);
+    strbf_puts(sb, "\"}}");
+}
+
+char *config_lock_trace_json(strbf_t *sb, uint8_t reset) {
+    strbf_puts(sb, "{\"traceEvents\":[");
+    // records are copied out one at a time, formatting runs outside the critical section
+    portENTER_CRITICAL(&config_trace_mux);
+    uint32_t head = config_trace_head;
+    portEXIT_CRITICAL(&config_trace_mux);
+    uint32_t n = head < CONFIG_LOGGER_CONFIG_LOCK_TRACE_SIZE ? head : CONFIG_LOGGER_CONFIG_LOCK_TRACE_SIZE;
+    for (uint32_t i = head - n; i != head; i++) {
+        config_trace_rec_t r;
+        portENTER_CRITICAL(&config_trace_mux);
+        r = config_trace_ring[i % CONFIG_LOGGER_CONFIG_LOCK_TRACE_SIZE];
+        portEXIT_CRITICAL(&config_trace_mux);
+        if (i != head - n)
+            strbf_putc(sb, ',');
+        strbf_puts(sb, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":");
+        strbf_putul(sb, r.tid);
+        strbf_puts(sb, ",\"args\":{\"name\":\"");
+        strbf_puts(sb, r.task);
+        strbf_puts(sb, "\"}},");
+        config_trace_put_event(sb, &r, "wait", r.start, r.wait_us);
+        strbf_putc(sb, ',');
+        config_trace_put_event(sb, &r, "hold", r.start + r.wait_us, r.hold_us);
+    }
+    if (reset) {
+        portENTER_CRITICAL(&config_trace_mux);
+        config_trace_head = 0;
+        portEXIT_CRITICAL(&config_trace_mux);
+    }
+    strbf_puts(sb, "],\"displayTimeUnit\":\"ms\"}");
+    return strbf_finish(sb);
+}
+
+#endif
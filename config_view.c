@@ -0,0 +1,205 @@
+#include <stdatomic.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "config_events.h"
+#include "config_fields.h"
+
+static const char *TAG = "config_view";
+
+#if !defined(CONFIG_LOGGER_CONFIG_VIEW_SLOTS)
+#define CONFIG_LOGGER_CONFIG_VIEW_SLOTS 4
+#endif
+#define CFG_VIEW_RETRY_US 10000 // publish retry while every spare view is still held by a reader
+
+// config first, so a view pointer is the config pointer handed to readers
+typedef struct config_view_s {
+    logger_config_t config;
+    uint32_t generation;
+    uint32_t cold_generation; // cold block in this slot is from this publish
+    atomic_uint refs;
+} config_view_t;
+
+static config_view_t config_views[CONFIG_LOGGER_CONFIG_VIEW_SLOTS];
+static _Atomic(config_view_t *) config_view_current = 0;
+static atomic_uint config_view_gen = 0;
+static SemaphoreHandle_t config_view_lock = 0; // writers only
+static uint32_t config_view_cold_gen = 0; // last publish that changed a cold item, writers only
+static logger_config_t config_view_next; // copy taken under the section locks, waiting for a free view
+static uint8_t config_view_staged = 0;
+static uint8_t config_view_retrying = 0;
+static esp_timer_handle_t config_view_retry_timer = 0;
+
+// changes not yet handed to the event loop, at most one changed event is queued at a time
+static _Atomic config_change_mask_t config_event_pending = 0;
+static atomic_bool config_event_queued = 0;
+static uint8_t config_event_handler_ready = 0;
+
+static void config_event_post_changed(void);
+
+// runs when the loop delivers a changed event, lets the next one through with whatever piled up meanwhile
+static void config_event_changed_handler(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    atomic_store(&config_event_queued, 0);
+    if (atomic_load(&config_event_pending))
+        config_event_post_changed();
+}
+
+static void config_event_post_changed(void) {
+    if (!config_event_handler_ready) {
+        if (esp_event_handler_register(CONFIG_EVENT, LOGGER_CONFIG_EVENT_CONFIG_CHANGED, config_event_changed_handler, 0) == ESP_OK)
+            config_event_handler_ready = 1;
+    }
+    if (config_event_handler_ready && atomic_exchange(&config_event_queued, 1))
+        return; // queued event not delivered yet, pending bits go with the next one
+    config_event_t ev = { .generation = atomic_load(&config_view_gen), .changed = atomic_exchange(&config_event_pending, 0) };
+    if (esp_event_post(CONFIG_EVENT, LOGGER_CONFIG_EVENT_CONFIG_CHANGED, &ev, sizeof(ev), 0) != ESP_OK) {
+        // queue full, keep the bits for the next change
+        atomic_fetch_or(&config_event_pending, ev.changed);
+        atomic_store(&config_event_queued, 0);
+    }
+}
+
+void config_post_event(int32_t id, const logger_config_t *config) {
+#if defined(CONFIG_LOGGER_CONFIG_EVENT_FULL_STRUCT)
+    esp_event_post(CONFIG_EVENT, id, config, sizeof(logger_config_t), portMAX_DELAY);
+#else
+    config_event_t ev = { .generation = atomic_load(&config_view_gen), .changed = 0 };
+    esp_event_post(CONFIG_EVENT, id, &ev, sizeof(ev), 0);
+#endif
+}
+
+const logger_config_t *config_view_acquire(uint32_t *generation) {
+    config_view_t *v;
+    for (;;) {
+        v = atomic_load(&config_view_current);
+        if (!v)
+            return 0;
+        atomic_fetch_add(&v->refs, 1);
+        // slot may have been recycled between load and ref, only trust it while still current
+        if (atomic_load(&config_view_current) == v)
+            break;
+        atomic_fetch_sub(&v->refs, 1);
+    }
+    if (generation)
+        *generation = v->generation;
+    return &v->config;
+}
+
+void config_view_release(const logger_config_t *view) {
+    if (!view)
+        return;
+    config_view_t *v = (config_view_t *)view;
+    assert(v >= config_views && v < config_views + CONFIG_LOGGER_CONFIG_VIEW_SLOTS);
+    atomic_fetch_sub(&v->refs, 1);
+}
+
+uint32_t config_view_generation(void) {
+    return atomic_load(&config_view_gen);
+}
+
+static inline void config_view_lock_init(void) {
+    if (!config_view_lock)
+        config_view_lock = xSemaphoreCreateMutex();
+}
+
+static void config_view_retry_cb(void *arg) {
+    if (config_view_commit() == ESP_OK)
+        config_notify();
+}
+
+/// every spare view still held by a reader, the staged copy goes out from the timer task once one is handed back
+static void config_view_retry(void) {
+    if (!config_view_retry_timer) {
+        const esp_timer_create_args_t args = { .callback = config_view_retry_cb, .name = "config_view" };
+        if (esp_timer_create(&args, &config_view_retry_timer) != ESP_OK) {
+            config_view_retry_timer = 0;
+            return; // left to the next publish
+        }
+    }
+    if (!esp_timer_is_active(config_view_retry_timer))
+        esp_timer_start_once(config_view_retry_timer, CFG_VIEW_RETRY_US);
+}
+
+void config_view_stage(const logger_config_t *config) {
+    config_view_lock_init();
+    xSemaphoreTake(config_view_lock, portMAX_DELAY);
+    memcpy(&config_view_next, config, sizeof(config_view_next));
+    config_view_staged = 1;
+    xSemaphoreGive(config_view_lock);
+}
+
+esp_err_t config_view_commit(void) {
+    config_view_lock_init();
+    xSemaphoreTake(config_view_lock, portMAX_DELAY);
+    if (!config_view_staged) {
+        xSemaphoreGive(config_view_lock);
+        return ESP_OK;
+    }
+    const logger_config_t *config = &config_view_next;
+    config_view_t *cur = atomic_load(&config_view_current), *v = 0;
+    config_change_mask_t changed = cur ? config_diff(&cur->config, config) : ~0ULL >> (64 - config_item_count);
+    if (!changed) {
+        config_view_staged = 0;
+        xSemaphoreGive(config_view_lock);
+        return ESP_OK;
+    }
+    for (uint8_t i = 0; i < CONFIG_LOGGER_CONFIG_VIEW_SLOTS; i++) {
+        if (&config_views[i] != cur && !atomic_load(&config_views[i].refs)) {
+            v = &config_views[i];
+            break;
+        }
+    }
+    if (!v) {
+        if (!config_view_retrying)
+            ESP_LOGW(TAG, "[%s] no free view, publish retried", __func__);
+        config_view_retrying = 1;
+        config_view_retry();
+        xSemaphoreGive(config_view_lock);
+        return ESP_ERR_NOT_FINISHED;
+    }
+    config_view_retrying = 0;
+    config_view_staged = 0;
+    v->generation = atomic_load(&config_view_gen) + 1;
+    // hot block every time, the cold one only when the slot holds an older one than the last cold change
+    if (changed & config_field_cold_items())
+        config_view_cold_gen = v->generation;
+    memcpy(&v->config.hot, &config->hot, sizeof(v->config.hot));
+    if (v->cold_generation != config_view_cold_gen) {
+        memcpy(&v->config.cold, &config->cold, sizeof(v->config.cold));
+        v->config.config_changed_screen_cb = 0;
+        v->config.config_changed_screen_sub = 0;
+        v->cold_generation = config_view_cold_gen;
+    }
+    atomic_store(&config_view_current, v);
+    atomic_store(&config_view_gen, v->generation);
+    atomic_fetch_or(&config_event_pending, changed);
+    config_notify_mark(changed);
+    xSemaphoreGive(config_view_lock);
+    DLOG(TAG, "[%s] generation %lu", __func__, (unsigned long)v->generation);
+    config_event_post_changed();
+    return ESP_OK;
+}
+
+esp_err_t config_view_publish(const logger_config_t *config) {
+    if (!config)
+        return ESP_ERR_INVALID_ARG;
+    config_view_stage(config);
+    return config_view_commit();
+}
+
+void config_view_deinit(void) {
+    if (config_view_retry_timer) {
+        esp_timer_stop(config_view_retry_timer);
+        esp_timer_delete(config_view_retry_timer);
+        config_view_retry_timer = 0;
+    }
+}
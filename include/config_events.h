@@ -1,6 +1,7 @@
 #ifndef E4637772_1304_4CBE_8AE1_F6191216D7FD
 #define E4637772_1304_4CBE_8AE1_F6191216D7FD
 
+#include <stdint.h>
 #include "esp_event.h"
 
 #ifdef __cplusplus
@@ -15,8 +16,15 @@ enum {
     LOGGER_CONFIG_EVENT_CONFIG_LOAD_FAIL,
     LOGGER_CONFIG_EVENT_CONFIG_SAVE_DONE,
     LOGGER_CONFIG_EVENT_CONFIG_SAVE_FAIL,
+    LOGGER_CONFIG_EVENT_CONFIG_CHANGED,
 };
 
+/// event data of LOGGER_CONFIG_EVENT_CONFIG_CHANGED, and of the other events unless LOGGER_CONFIG_EVENT_FULL_STRUCT is set
+typedef struct config_event_s {
+    uint32_t generation; // config_view generation, config_view_acquire gives the values
+    uint64_t changed;    // config_change_mask_t of items changed since the previous changed event
+} config_event_t;
+
 #ifdef __cplusplus
 }
 #endif
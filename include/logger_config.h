@@ -47,7 +47,103 @@ extern const char *config_item_names;
 #define CFG_FW_UPDATE_ITEM_LIST(l) l(update_enabled) l(update_channel)
 #define CFG_ITEM_LIST(l) l(speed_large_font) l(bar_length) l(stat_speed) l(archive_days) l(file_date_time) l(ssid) l(password) l(ssid1) l(password1) l(ssid2) l(password2) l(ssid3) l(password3) l(gpio12_screens) l(ubx_file) l(sleep_info) l(hostname)
 
+// on/off settings packed one bit each into the flags byte of their struct, in bit order, lsb first
+#define CFG_GPS_FLAG_LIST(l) l(log_txt) l(log_ubx) l(log_sbp) l(log_gpy) l(log_gpx) l(log_ubx_nav_sat)
+#define CFG_SCREEN_FLAG_LIST(l) l(speed_large_font) l(screen_no_auto_refresh)
+#define CFG_FW_UPDATE_FLAG_LIST(l) l(update_enabled)
+#define CFG_MISC_FLAG_LIST(l) l(screen_move_offset)
+
+// storage of each item in logger_config_t: member, value kind, FLAG items name the flags byte holding their bit
+#define CFG_FIELD_cal_bat cal_bat, FLOAT
+#define CFG_FIELD_gnss gps.gnss, UINT
+#define CFG_FIELD_sample_rate gps.sample_rate, UINT
+#define CFG_FIELD_timezone timezone, FLOAT
+#define CFG_FIELD_speed_unit gps.speed_unit, UINT
+#define CFG_FIELD_log_txt gps.flags, FLAG
+#define CFG_FIELD_log_ubx gps.flags, FLAG
+#define CFG_FIELD_log_sbp gps.flags, FLAG
+#define CFG_FIELD_log_gpy gps.flags, FLAG
+#define CFG_FIELD_log_gpx gps.flags, FLAG
+#define CFG_FIELD_log_ubx_nav_sat gps.flags, FLAG
+#define CFG_FIELD_dynamic_model gps.dynamic_model, UINT
+#define CFG_FIELD_speed_field screen.speed_field, UINT
+#define CFG_FIELD_stat_screens_time screen.stat_screens_time, UINT
+#define CFG_FIELD_stat_screens screen.stat_screens, BITS
+#define CFG_FIELD_board_logo screen.board_logo, UINT
+#define CFG_FIELD_sail_logo screen.sail_logo, UINT
+#define CFG_FIELD_screen_rotation screen.screen_rotation, INT
+#define CFG_FIELD_screen_move_offset flags, FLAG
+#define CFG_FIELD_screen_brightness screen_brightness, UINT
+#define CFG_FIELD_update_enabled fwupdate.flags, FLAG
+#define CFG_FIELD_update_channel fwupdate.channel, UINT
+#define CFG_FIELD_speed_large_font screen.flags, FLAG
+#define CFG_FIELD_bar_length bar_length, UINT
+#define CFG_FIELD_stat_speed screen.stat_speed, UINT
+#define CFG_FIELD_archive_days archive_days, UINT
+#define CFG_FIELD_file_date_time file_date_time, UINT
+#define CFG_FIELD_ssid wifi_sta[0].ssid, STR
+#define CFG_FIELD_password wifi_sta[0].password, STR
+#define CFG_FIELD_ssid1 wifi_sta[1].ssid, STR
+#define CFG_FIELD_password1 wifi_sta[1].password, STR
+#define CFG_FIELD_ssid2 wifi_sta[2].ssid, STR
+#define CFG_FIELD_password2 wifi_sta[2].password, STR
+#define CFG_FIELD_ssid3 wifi_sta[3].ssid, STR
+#define CFG_FIELD_password3 wifi_sta[3].password, STR
+#define CFG_FIELD_gpio12_screens screen.gpio12_screens, UINT
+#define CFG_FIELD_ubx_file ubx_file, STR
+#define CFG_FIELD_sleep_info sleep_info, STR
+#define CFG_FIELD_hostname hostname, STR
+
+// accepted value range of each item: min, max, unused for strings
+#define CFG_RANGE_cal_bat 0, 10
+#define CFG_RANGE_gnss 0, 255
+#define CFG_RANGE_sample_rate 1, 20
+#define CFG_RANGE_timezone -12, 14
+#define CFG_RANGE_speed_unit 0, 2
+#define CFG_RANGE_log_txt 0, 1
+#define CFG_RANGE_log_ubx 0, 1
+#define CFG_RANGE_log_sbp 0, 1
+#define CFG_RANGE_log_gpy 0, 1
+#define CFG_RANGE_log_gpx 0, 1
+#define CFG_RANGE_log_ubx_nav_sat 0, 1
+#define CFG_RANGE_dynamic_model 0, 2
+#define CFG_RANGE_speed_field 1, 9
+#define CFG_RANGE_stat_screens_time 1, 5
+#define CFG_RANGE_stat_screens 0, UINT16_MAX
+#define CFG_RANGE_board_logo 1, 11
+#define CFG_RANGE_sail_logo 1, 12
+#define CFG_RANGE_screen_rotation 0, 3
+#define CFG_RANGE_screen_move_offset 0, 1
+#define CFG_RANGE_screen_brightness 0, 100
+#define CFG_RANGE_update_enabled 0, 1
+#define CFG_RANGE_update_channel 0, 1
+#define CFG_RANGE_speed_large_font 0, 1
+#define CFG_RANGE_bar_length 0, UINT16_MAX
+#define CFG_RANGE_stat_speed 0, UINT8_MAX
+#define CFG_RANGE_archive_days 0, UINT16_MAX
+#define CFG_RANGE_file_date_time 0, 2
+#define CFG_RANGE_ssid 0, 0
+#define CFG_RANGE_password 0, 0
+#define CFG_RANGE_ssid1 0, 0
+#define CFG_RANGE_password1 0, 0
+#define CFG_RANGE_ssid2 0, 0
+#define CFG_RANGE_password2 0, 0
+#define CFG_RANGE_ssid3 0, 0
+#define CFG_RANGE_password3 0, 0
+#define CFG_RANGE_gpio12_screens 0, UINT16_MAX
+#define CFG_RANGE_ubx_file 0, 0
+#define CFG_RANGE_sleep_info 0, 0
+#define CFG_RANGE_hostname 0, 0
+
 #define CFG_ENUM(l) cfg_##l,
+#define CFG_FLAG_POS(l) cfg_flag_##l,
+#define CFG_FLAG_MEMBER(l) uint8_t l : 1;
+
+// bit of each flag in its flags byte
+enum { CFG_GPS_FLAG_LIST(CFG_FLAG_POS) };
+enum { CFG_SCREEN_FLAG_LIST(CFG_FLAG_POS) };
+enum { CFG_FW_UPDATE_FLAG_LIST(CFG_FLAG_POS) };
+enum { CFG_MISC_FLAG_LIST(CFG_FLAG_POS) };
 
 // configuration items in enum
 typedef enum {
@@ -59,6 +155,17 @@ typedef enum {
     CFG_ITEM_LIST(CFG_ENUM)
 } config_item_t;
 
+// set of config_item_t, bit n for item n
+typedef uint64_t config_change_mask_t;
+#define CFG_BIT(l) | (1ULL << cfg_##l)
+#define CFG_CHANGED(mask, item) (((mask) >> (item)) & 1)
+#define CFG_GPS_ITEMS_MASK (0ULL CFG_GPS_ITEM_LIST(CFG_BIT))
+#define CFG_GPS_HW_ITEMS_MASK (0ULL CFG_BIT(gnss) CFG_BIT(sample_rate) CFG_BIT(dynamic_model)) // need ublox reconfiguration
+#define CFG_SCREEN_ITEMS_MASK (0ULL CFG_SCREEN_ITEM_LIST(CFG_BIT) CFG_SCREEN_ITEM_LIST_A(CFG_BIT) CFG_BIT(speed_large_font) CFG_BIT(stat_speed) CFG_BIT(bar_length) CFG_BIT(gpio12_screens))
+#define CFG_FW_UPDATE_ITEMS_MASK (0ULL CFG_FW_UPDATE_ITEM_LIST(CFG_BIT))
+#define CFG_WIFI_ITEMS_MASK (0ULL CFG_BIT(ssid) CFG_BIT(password) CFG_BIT(ssid1) CFG_BIT(password1) CFG_BIT(ssid2) CFG_BIT(password2) CFG_BIT(ssid3) CFG_BIT(password3) CFG_BIT(hostname))
+#define CFG_PROFILE_ITEMS_MASK (CFG_GPS_ITEMS_MASK | CFG_SCREEN_ITEMS_MASK) // items a profile switch replaces
+
 typedef struct logger_config_item_s {
     const char * name;
     int pos;
@@ -70,13 +177,13 @@ typedef struct logger_config_gps_s {
     uint8_t gnss;             // default setting 2 GNSS, GPS & GLONAS
     uint8_t sample_rate;      // gps_rate in Hz, 1, 5 or 10Hz !!!
     uint8_t speed_unit;       // 0 = m/s, 1 = km/h, 2 = knots
-    uint8_t log_txt;          // switchinf off .txt files
-    uint8_t log_ubx;          // log to .ubx
-    uint8_t log_sbp;          // log to .sbp
-    uint8_t log_gpy;          // log to .gps
-    uint8_t log_gpx;          // log to .gpx
-    uint8_t log_ubx_nav_sat;  // log nav sat msg to .ubx
     uint8_t dynamic_model;    // choice for dynamic model "Sea",if 0 model "portable" is used !!
+    // log_txt switches off .txt files, log_ubx, log_sbp, log_gpy and log_gpx log to their files,
+    // log_ubx_nav_sat adds nav sat msg to .ubx
+    union {
+        struct { CFG_GPS_FLAG_LIST(CFG_FLAG_MEMBER) };
+        uint8_t flags;
+    };
 } logger_config_gps_t;
 // #define L_CONFIG_GPS_FIELDS sizeof(struct logger_config_gps_s)
 #define LOGGER_CONFIG_GPS_DEFAULTS() { \
@@ -157,25 +264,28 @@ typedef struct logger_config_stat_screens_s {
 
 typedef struct logger_config_screen_s {
     uint8_t speed_field;             // choice for first field in speed screen !!!
-    uint8_t speed_large_font;        // fonts on the first line are bigger, actual speed font is smaller
     uint8_t stat_screens_time;       // time between switching stat_screens
     uint8_t board_logo;
     uint8_t sail_logo;
     int8_t screen_rotation;
-    uint8_t screen_no_auto_refresh;
     uint8_t stat_speed;       // max speed in m/s for showing Stat screens
+    // speed_large_font: fonts on the first line are bigger, actual speed font is smaller
+    union {
+        struct { CFG_SCREEN_FLAG_LIST(CFG_FLAG_MEMBER) };
+        uint8_t flags;
+    };
     uint16_t stat_screens;    // choice for stats field when no speed, here stat_screen 1, 2 and 3 will be active
     uint16_t gpio12_screens;  // choice for stats field when gpio12 is activated (pull-up high, low = active)
 } logger_config_screen_t;
 // #define L_CONFIG_SCREEN_FIELDS sizeof(struct logger_config_screen_s)
 #define LOGGER_CONFIG_SCREEN_DEFAULTS() { \
     .speed_field = 1, \
-    .speed_large_font = 0, \
     .stat_screens_time = 3, \
     .board_logo = 1, \
     .sail_logo = 1, \
     .stat_speed = 1, \
     .screen_rotation = SCR_DEFAULT_ROTATION, \
+    .speed_large_font = 0, \
     .screen_no_auto_refresh = !SCR_AUTO_REFRESH, \
     .stat_screens = 255U, \
     .gpio12_screens = 255U, \
@@ -187,8 +297,11 @@ typedef enum {
 } fw_update_channel_t;
 
 typedef struct logger_config_fwupdate_c {
-    bool update_enabled;
-    fw_update_channel_t channel;
+    union {
+        struct { CFG_FW_UPDATE_FLAG_LIST(CFG_FLAG_MEMBER) };
+        uint8_t flags;
+    };
+    uint8_t channel; // fw_update_channel_t
 } logger_config_fwupdate_t;
 
 #if defined(CONFIG_LOGGER_BUILD_MODE_DEV)
@@ -209,27 +322,63 @@ typedef struct logger_config_wifi_sta_s {
     char password[32];    // your password
 } logger_config_wifi_sta_t;
 
+// read on every gps sample and display frame, kept within one cache line
+#define LOGGER_CONFIG_HOT_MEMBERS \
+    logger_config_gps_t gps; \
+    logger_config_screen_t screen; \
+    float timezone;           /* choice for timedifference in hours with UTC, for Belgium 1 or 2 (summertime) */ \
+    uint16_t bar_length;      /* choice for bar indicator for length of run in m (nautical mile) */ \
+    uint8_t screen_brightness; \
+    uint8_t file_date_time;   /* type of filenaming, with MAC adress or datetime */ \
+    uint8_t config_fail; \
+    uint8_t speed_field_count; \
+    union { \
+        struct { CFG_MISC_FLAG_LIST(CFG_FLAG_MEMBER) }; \
+        uint8_t flags; \
+    };
+
+#if defined(CUSTOM_CALIBRATION_VAL)
+#define LOGGER_CONFIG_COLD_CAL_BAT float cal_bat; /* calibration for read out bat voltage */
+#else
+#define LOGGER_CONFIG_COLD_CAL_BAT
+#endif
+
+// strings and rarely read settings
+#define LOGGER_CONFIG_COLD_MEMBERS \
+    uint16_t archive_days;    /* how many days files will be moved to the "Archive" dir */ \
+    char ubx_file[32];        /* your preferred filename */ \
+    char sleep_info[32];      /* your preferred sleep text */ \
+    struct logger_config_fwupdate_c fwupdate; \
+    struct logger_config_wifi_sta_s wifi_sta[L_CONFIG_SSID_MAX]; /* your SSID and password */ \
+    char hostname[32];        /* your hostname */ \
+    LOGGER_CONFIG_COLD_CAL_BAT \
+    void(*config_changed_screen_cb)(const char *name); \
+    int8_t config_changed_screen_sub; /* subscription serving config_changed_screen_cb, handle + 1, 0 for none */
+
+#define CFG_HOT_BLOCK_MAX 32
+
+typedef struct logger_config_hot_s {
+    LOGGER_CONFIG_HOT_MEMBERS
+} logger_config_hot_t;
+
+typedef struct logger_config_cold_s {
+    LOGGER_CONFIG_COLD_MEMBERS
+} logger_config_cold_t;
+
+/*
+* Members stay reachable by their old names, config->gps.log_txt or config->hostname,
+* hot and cold name the same bytes as blocks for copying only what a reader needs.
+* The cold block stays inline, behind a pointer the struct would no longer copy by value or take the defaults initializer.
+*/
 typedef struct logger_config_s {
-    logger_config_gps_t gps;
-    logger_config_screen_t screen;
-    float timezone;           // choice for timedifference in hours with UTC, for Belgium 1 or 2 (summertime)
-    uint8_t file_date_time;   // type of filenaming, with MAC adress or datetime
-    uint8_t config_fail;
-    int8_t  screen_move_offset;
-    uint8_t speed_field_count;
-    uint16_t bar_length;      // choice for bar indicator for length of run in m (nautical mile)
-    uint8_t screen_brightness;
-
-    uint16_t archive_days;    // how many days files will be moved to the "Archive" dir
- 
-    char ubx_file[32];    // your preferred filename
-    char sleep_info[32];  // your preferred sleep text
-
-    struct logger_config_fwupdate_c fwupdate;
-
-    struct logger_config_wifi_sta_s wifi_sta[L_CONFIG_SSID_MAX]; // your SSID and password
-    char hostname[32];    // your hostname
-    void(*config_changed_screen_cb)(const char *name);
+    union {
+        struct { LOGGER_CONFIG_HOT_MEMBERS };
+        logger_config_hot_t hot;
+    };
+    union {
+        struct { LOGGER_CONFIG_COLD_MEMBERS };
+        logger_config_cold_t cold;
+    };
 } logger_config_t;
 
 #define LOGGER_CONFIG_DEFAULTS() { \
@@ -241,8 +390,8 @@ typedef struct logger_config_s {
     .speed_field_count = L_CONFIG_SPEED_FIELDS, \
     .bar_length = 1852, \
     .screen_brightness = 100, \
-    .archive_days = 30, \
     .timezone = 2, \
+    .archive_days = 30, \
     .ubx_file = "gps", \
     .sleep_info = "ESP GPS", \
     .fwupdate = LOGGER_CONFIG_FWUPDATE_DEFAULTS(), \
@@ -254,6 +403,7 @@ typedef struct logger_config_s {
         { {0}, {0} }, \
     }, \
     .config_changed_screen_cb = NULL, \
+    .config_changed_screen_sub = 0, \
 }
 
 struct strbf_s;
@@ -282,11 +432,18 @@ struct logger_config_s *config_init(struct logger_config_s *config);
 void config_deinit(struct logger_config_s *config);
 
 /*
-* @brief Load config defaults
+* @brief Load config defaults, the built-in values with the optional site default.json on top
 * @param config The configuration to load defaults into
 */
 struct logger_config_s *config_defaults(struct logger_config_s *config);
 
+/*
+* @brief Items that differ from the defaults, only these are written to the config files
+* @param config The configuration
+* @return config_change_mask_t with a bit set for every overridden item
+*/
+config_change_mask_t config_overrides(const struct logger_config_s *config);
+
 /*
 * @brief Get a variable from the configuration
 * @param config The configuration to get the variable from
@@ -323,13 +480,120 @@ int config_load_json(struct logger_config_s *config);
 */
 int config_save_json(struct logger_config_s *config, uint8_t ublox_hw);
 
+/*
+* @brief Mark the configuration dirty, it is saved once no further change came in for LOGGER_CONFIG_SAVE_DELAY_MS
+* @param config The configuration to save
+* @param ublox_hw The ublox hardware type passed on to config_save_json
+*/
+void config_save_later(struct logger_config_s *config, uint8_t ublox_hw);
+
+/*
+* @brief Save a pending configuration change now, call before shutdown or deep sleep
+* With LOGGER_CONFIG_JSON_MIRROR it also rewrites config.txt when journaled changes are not in it yet
+* @return ESP_OK when nothing was pending or the save succeeded
+*/
+int config_flush(void);
+
 /*
 * @brief Decode a JSON string into a configuration
 * @param config The configuration to save
 * @param json The JSON string to decode
+* @return ESP_OK, ESP_FAIL on bad JSON, ESP_ERR_NOT_FINISHED when applied but readers still see the previous view,
+* the publish is then retried
 */
 int config_decode(struct logger_config_s *config, const char *json);
 
+/*
+* @brief Copy already checked items from a staged copy into the live configuration, publish and save later
+* @param config The live configuration
+* @param staged The copy holding the new values
+* @param items config_change_mask_t of the items to take from staged
+* @param ublox_hw The ublox hardware type, for the saved file
+* @return ESP_OK, ESP_ERR_NOT_FINISHED when applied but every spare view is still held by a reader, the publish is then retried
+*/
+esp_err_t config_apply(struct logger_config_s *config, const struct logger_config_s *staged, config_change_mask_t items, uint8_t ublox_hw);
+
+/*
+* @brief Changes staged in a copy of the configuration, checked and saved together on commit
+*/
+typedef struct config_txn_s {
+    struct logger_config_s *config; // live configuration, NULL when not open
+    struct logger_config_s staged;
+    config_change_mask_t changed;
+    uint8_t ublox_hw;
+} config_txn_t;
+
+/*
+* @brief Start a transaction on a copy of the configuration
+* @param txn The transaction, usually on the stack
+* @param config The live configuration
+* @param ublox_hw The ublox hardware type, for the saved file
+*/
+esp_err_t config_txn_begin(config_txn_t *txn, struct logger_config_s *config, uint8_t ublox_hw);
+
+/*
+* @brief Stage one item
+* @param txn The transaction
+* @param name The item name, legacy spellings included
+* @param value The new value
+* @return config_item_t of the item, -1 when unchanged, -2 when unknown, of the wrong type or out of range
+*/
+int config_txn_set(config_txn_t *txn, const char *name, const JsonNode *value);
+
+/*
+* @brief Stage every member of a JSON object
+* @param txn The transaction
+* @param json The JSON object, like {"sample_rate":10,"ssid":"home"}
+* @return Number of changed items, -1 on bad JSON or when an item could not be staged
+*/
+int config_txn_set_json(config_txn_t *txn, const char *json);
+
+/*
+* @brief Check all staged items in one pass, then apply them with one save and one notification
+* @param txn The transaction, closed afterwards
+* @return ESP_OK, ESP_ERR_INVALID_ARG when an item is out of range, the save error otherwise, the live configuration is untouched on error;
+* ESP_ERR_NOT_FINISHED when saved and applied but not yet published to readers, the publish is then retried
+*/
+esp_err_t config_txn_commit(config_txn_t *txn);
+
+/*
+* @brief Drop the staged changes
+* @param txn The transaction, closed afterwards
+*/
+void config_txn_abort(config_txn_t *txn);
+
+#if (CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN > 0)
+/*
+* @brief Start the task that owns config and applies queued commands in batches, one transaction per batch
+* @param config The live configuration
+* @param ublox_hw The ublox hardware type, for the saved file
+*/
+esp_err_t config_service_start(struct logger_config_s *config, uint8_t ublox_hw);
+
+/*
+* @brief Apply what is queued and stop the command task, done by config_deinit
+*/
+void config_service_stop(void);
+
+/*
+* @brief Queue a new value for a number, bool or bits item, never blocks
+* @return ESP_OK when queued, ESP_ERR_NO_MEM when the queue is full, ESP_ERR_INVALID_STATE before config_service_start
+*/
+esp_err_t config_cmd_set_num(config_item_t item, double value);
+
+/*
+* @brief Queue a new value for a string item, never blocks, values of 32 chars or more are refused
+* @return ESP_OK when queued, ESP_ERR_NO_MEM when the queue is full, ESP_ERR_INVALID_SIZE when value is too long, ESP_ERR_INVALID_STATE before config_service_start
+*/
+esp_err_t config_cmd_set_str(config_item_t item, const char *value);
+
+/*
+* @brief Queue one menu step of an item, like the set_*_cfg_item functions, never blocks
+* @return ESP_OK when queued, ESP_ERR_NO_MEM when the queue is full, ESP_ERR_INVALID_STATE before config_service_start
+*/
+esp_err_t config_cmd_step(config_item_t item);
+#endif
+
 /*
 * @brief Fix values in the configuration
 * @param config The configuration to fix values in
@@ -345,21 +609,53 @@ struct logger_config_s *config_fix_values(struct logger_config_s *config);
 char *config_get_json(struct logger_config_s * config, struct strbf_s *sb, const char *str, uint8_t ublox_hw);
 
 /*
-* @brief Compare two configurations
+* @brief Compare two configurations, through config_diff so the cold block is only walked when it differs
 * @param orig The original configuration
 * @param config The configuration to compare
 */
 int config_compare(struct logger_config_s *orig, struct logger_config_s *config);
 
 /*
-* @brief Clone a configuration
+* @brief Compare two configurations in one pass
+* @param orig The original configuration
+* @param config The configuration to compare
+* @return config_change_mask_t with a bit set for every item that differs
+*/
+config_change_mask_t config_diff(const struct logger_config_s *orig, const struct logger_config_s *config);
+
+/*
+* @brief Clone a configuration, hot and cold block both, the copy is a standalone config the caller may edit and pass anywhere
 * @param orig The original configuration
 * @param config The configuration to clone into
 */
 struct logger_config_s *config_clone(struct logger_config_s *orig, struct logger_config_s *config);
 
 /*
-* @brief Encode a configuration into a JSON string
+* @brief Metadata of all items for the web ui: name, info, type, ext and values, no current values
+* @param ublox_hw The receiver type, items and values not available on it are left out
+* @param len Set to the length of the returned string, may be NULL
+* @return JSON array built once and kept, do not free, NULL when out of memory
+*/
+const char *config_schema_json(uint8_t ublox_hw, size_t *len);
+
+/*
+* @brief Receives encoded output piece by piece
+* @return 0 to continue, anything else stops the encoder
+*/
+typedef int (*config_sink_t)(void *ctx, const char *buf, size_t len);
+
+/*
+* @brief Encode a configuration like config_encode_json without building it in memory
+* @param config The configuration to encode
+* @param ublox_hw The receiver type
+* @param sink Called with pieces of at most 256 bytes, e.g. a file, http chunk or uart writer
+* @param ctx Passed to the sink
+* @return ESP_OK, ESP_FAIL when the sink stopped
+*/
+esp_err_t config_encode_stream(const logger_config_t *config, uint8_t ublox_hw, config_sink_t sink, void *ctx);
+
+/*
+* @brief Encode a configuration into a JSON string, the compact current values to go with config_schema_json
 * @param config The configuration to encode
 * @param sb The string builder to use
 */
@@ -393,8 +689,227 @@ int config_save_var(struct logger_config_s *config, const char *json, const char
 */
 int config_save_var_b(struct logger_config_s *config, const char *json, uint8_t ublox_hw);
 
+/*
+* @brief Resolve a configuration item name, legacy spellings included
+* @param name The name of the item
+* @return config_item_t of the item or -1 when name is unknown
+*/
+int config_item_lookup(const char *name);
+
+/*
+* @brief Legacy single callback with the changed item name, now served through config_subscribe
+* Each config has its own callback. It is called once per changed item for every change, menu steps, decoded text,
+* profile switches and loads included, not only for config_set_var. It runs in the task that made the change.
+* @param config The configuration the callback belongs to
+* @param cb The callback, NULL to remove it
+* @return ESP_OK, ESP_ERR_NO_MEM when no subscription is free
+*/
 esp_err_t config_set_screen_cb(logger_config_t * config, void(*cb)(const char *));
 
+/*
+* @brief Get the latest published configuration without taking the config lock
+* @param generation Set to the generation of the returned view, may be NULL
+* @return Immutable configuration, hand back with config_view_release, NULL before the first publish
+*/
+const logger_config_t *config_view_acquire(uint32_t *generation);
+
+/*
+* @brief Release a view from config_view_acquire
+* @param view The view to release
+*/
+void config_view_release(const logger_config_t *view);
+
+/*
+* @brief Generation of the latest published configuration, cheap check whether a reader needs to acquire again
+*/
+uint32_t config_view_generation(void);
+
+/*
+* @brief Publish a copy of the configuration for lock-free readers, done by the config module after every change
+* @param config The configuration to publish, the caller keeps it from changing during the call
+* @return ESP_OK, ESP_ERR_NOT_FINISHED when every spare view is still held by a reader; the copy is kept and published
+* from a timer once one is handed back, it never waits for readers
+*/
+esp_err_t config_view_publish(const logger_config_t *config);
+
+/*
+* @brief Called with the subscribed items that changed and the view holding their new values
+*/
+typedef void (*config_subscriber_cb_t)(config_change_mask_t changed, const logger_config_t *view, void *ctx);
+
+/*
+* @brief Get called once per committed change set that touches any item in mask, outside the config lock
+* @param mask config_change_mask_t of the items of interest
+* @param cb The callback
+* @param ctx Passed to the callback
+* @return Handle for config_unsubscribe, -1 when the table is full
+*/
+int config_subscribe(config_change_mask_t mask, config_subscriber_cb_t cb, void *ctx);
+
+/*
+* @brief Remove a subscription
+* @param handle The handle from config_subscribe
+*/
+void config_unsubscribe(int handle);
+
+// config lock sections in the order they are taken, items outside the other section masks are misc
+#define CFG_LOCK_SECTION_LIST(l) l(gps) l(screen) l(fwupdate) l(wifi) l(misc)
+// hold_<section> in CFG_LOCK_SECTION_LIST order, hold_store is the persistence lock
+#define CFG_METRIC_LIST(l) l(load) l(decode) l(encode) l(save) l(set) l(lock_wait) \
+    l(hold_gps) l(hold_screen) l(hold_fwupdate) l(hold_wifi) l(hold_misc) l(hold_store)
+#define CFG_SAVE_TRIGGER_LIST(l) l(menu) l(web) l(decode) l(api)
+#define CFG_METRIC_ENUM(l) cfg_metric_##l,
+#define CFG_SAVE_TRIGGER_ENUM(l) cfg_save_##l,
+
+typedef enum {
+    CFG_METRIC_LIST(CFG_METRIC_ENUM)
+    cfg_metric_count
+} config_metric_t;
+
+typedef enum {
+    CFG_SAVE_TRIGGER_LIST(CFG_SAVE_TRIGGER_ENUM)
+    cfg_save_trigger_count
+} config_save_trigger_t;
+
+// latency histogram buckets below 100us, 300us, 1ms, 3ms, 10ms, 30ms, 100ms and above
+#define CFG_METRIC_BUCKETS 8
+
+typedef struct config_metric_timing_s {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t hist[CFG_METRIC_BUCKETS];
+} config_metric_timing_t;
+
+/*
+* @brief Counters of the config module since boot or the last reset
+*/
+typedef struct config_metrics_s {
+    config_metric_timing_t timing[cfg_metric_count];
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint32_t saves[cfg_save_trigger_count]; // menu, web ui, imported text file, direct config_save_json
+} config_metrics_t;
+
+/*
+* @brief Read the config metrics
+* @param metrics Filled with the counters, may be NULL
+* @param reset Clear the counters afterwards
+*/
+void config_metrics_get(config_metrics_t *metrics, uint8_t reset);
+
+/*
+* @brief Config metrics as JSON object, one entry per timing with count, total_us, max_us and hist
+* @param sb The string builder to use
+* @param reset Clear the counters afterwards
+*/
+char *config_metrics_json(struct strbf_s *sb, uint8_t reset);
+
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+#define CFG_PROFILE_NAME_MAX 16
+
+/*
+* @brief Store the gps and screen items of a configuration as named profile, replaces a profile of the same name
+* @param config The configuration to take the items from
+* @param name Profile name, at most 15 chars
+* @return Index of the profile, -1 when all profiles are in use or on write error
+*/
+int config_profile_save(struct logger_config_s *config, const char *name);
+
+/*
+* @brief Make a stored profile active, writes the active profile marker and journals the items that differ
+* @param config The configuration to apply the profile to, subscribers see only the items that differ
+* @param idx Index of the profile
+* @return ESP_OK, ESP_ERR_INVALID_ARG for an unused index, ESP_FAIL on write error, ESP_ERR_NOT_FINISHED when not yet published
+*/
+esp_err_t config_profile_select(struct logger_config_s *config, int idx);
+
+/*
+* @brief Index of a profile by name, -1 when not found
+*/
+int config_profile_find(const char *name);
+
+/*
+* @brief Index of the active profile, -1 when none was selected
+*/
+int config_profile_active(void);
+
+/*
+* @brief Name of a profile, NULL for an unused index
+*/
+const char *config_profile_name(int idx);
+#endif
+
+#if defined(CONFIG_LOGGER_CONFIG_LOCK_TRACE)
+/*
+* @brief Recent config lock acquisitions in Chrome trace-event format, a wait and a hold slice per acquisition named after the operation, the lock as argument
+* @param sb The string builder to use
+* @param reset Clear the trace afterwards
+*/
+char *config_lock_trace_json(struct strbf_s *sb, uint8_t reset);
+#endif
+
+#if defined(CONFIG_LOGGER_CONFIG_STORAGE_SIM)
+/*
+* @brief Simulated card behaviour added to every config file write and rename
+*/
+typedef struct config_storage_profile_s {
+    uint32_t open_us;      // fixed cost per write, open
+    uint32_t write_us;     // fixed cost per write, data
+    uint32_t fsync_us;     // fixed cost per write, close and flush
+    uint32_t rename_us;    // fixed cost per rename
+    uint32_t jitter_us;    // random extra 0..jitter_us per operation
+    uint32_t bytes_per_ms; // throughput limit, 0 for unlimited
+} config_storage_profile_t;
+
+/*
+* @brief Time spent in config file writes and renames, including simulated latency
+*/
+typedef struct config_storage_stats_s {
+    uint32_t ops;
+    uint32_t bytes;
+    uint64_t io_us;         // total time callers were blocked in storage
+    uint32_t io_max_us;
+    uint64_t locked_us;     // part of io_us during which the caller held a config section lock
+    uint32_t locked_max_us;
+} config_storage_stats_t;
+
+/*
+* @brief Set the simulated storage profile
+* @param profile The profile, NULL to turn simulation off
+*/
+void config_storage_sim_set(const config_storage_profile_t *profile);
+
+/*
+* @brief Read storage timing statistics
+* @param stats Filled with the counters, may be NULL
+* @param reset Clear the counters afterwards
+*/
+void config_storage_stats(config_storage_stats_t *stats, uint8_t reset);
+#endif
+
+/*
+* @brief Where the configuration is persisted, load and store are required, the others optional
+*/
+typedef struct config_store_s {
+    const char *name;
+    esp_err_t (*load)(struct logger_config_s *config);                          // ESP_ERR_NOT_FOUND when nothing stored
+    esp_err_t (*store)(const struct logger_config_s *config, uint8_t ublox_hw); // whole configuration
+    esp_err_t (*store_field)(const struct logger_config_s *config, uint8_t item); // one item, failure falls back to store
+    esp_err_t (*sync)(void);                                                    // after a run of store_field calls
+} config_store_t;
+
+extern const config_store_t config_store_file; // config.txt, snapshot and journal in the config directory
+extern const config_store_t config_store_ram;  // kept in memory only, lost on reset
+extern const config_store_t config_store_kv;   // one key per item, nvs on the device
+
+/*
+* @brief Switch the store used by load and save, the default is chosen in menuconfig
+* @param store The store, must stay valid while in use
+* @return ESP_OK, ESP_ERR_INVALID_ARG when load or store is missing
+*/
+esp_err_t config_store_use(const config_store_t *store);
+
 logger_config_item_t * get_gps_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item);
 int set_gps_cfg_item(logger_config_t *config, int num, uint8_t ublox_hw);
 logger_config_item_t * get_stat_screen_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item);
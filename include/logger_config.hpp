@@ -0,0 +1,169 @@
+#ifndef A77DABC5_B5F9_4949_AD1A_7311107F98BC
+#define A77DABC5_B5F9_4949_AD1A_7311107F98BC
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "logger_config.h"
+
+/*
+ * Typed access to the configuration items for C++, generated from the item lists in logger_config.h.
+ * Type, range and change bit of every item are compile time constants, so a read is one member load
+ * and a write marks its dirty bit without any name lookup.
+ *
+ *   cfg::snapshot snap;
+ *   uint8_t rate = cfg::get<cfg::field::sample_rate>(snap);
+ *
+ *   cfg::txn txn(*config, ublox_hw);
+ *   cfg::set<cfg::field::sample_rate>(txn, 10);
+ *   txn.commit();
+ */
+namespace cfg {
+
+#define CFG_CPP_FIELD(n) n = cfg_##n,
+enum class field : uint8_t {
+    CFG_CALIBRATION_ITEM_LIST(CFG_CPP_FIELD)
+    CFG_GPS_ITEM_LIST(CFG_CPP_FIELD)
+    CFG_SCREEN_ITEM_LIST(CFG_CPP_FIELD)
+    CFG_SCREEN_ITEM_LIST_A(CFG_CPP_FIELD)
+    CFG_FW_UPDATE_ITEM_LIST(CFG_CPP_FIELD)
+    CFG_ITEM_LIST(CFG_CPP_FIELD)
+};
+#undef CFG_CPP_FIELD
+
+template <field F> struct traits;
+
+/// type is the stored type, value_type what get returns, const char * for strings,
+/// put stores a number, buf is the storage of a string
+#define CFG_CPP_TRAITS(n) CFG_CPP_TRAITS_I(n, CFG_FIELD_##n, CFG_RANGE_##n)
+#define CFG_CPP_TRAITS_I(...) CFG_CPP_TRAITS_II(__VA_ARGS__)
+#define CFG_CPP_TRAITS_II(n, member, kind, lo, hi) \
+    template <> struct traits<field::n> { \
+        CFG_CPP_ACCESS_##kind(n, member) \
+        static constexpr config_item_t item = cfg_##n; \
+        static constexpr config_change_mask_t bit = 1ULL << cfg_##n; \
+        static constexpr int32_t min = lo, max = hi; \
+    };
+#define CFG_CPP_ACCESS_NUM(n, member) \
+    using type = std::remove_reference_t<decltype(std::declval<logger_config_t &>().member)>; \
+    using value_type = type; \
+    static value_type get(const logger_config_t &c) { return c.member; } \
+    static void put(logger_config_t &c, type v) { c.member = v; }
+#define CFG_CPP_ACCESS_UINT CFG_CPP_ACCESS_NUM
+#define CFG_CPP_ACCESS_INT CFG_CPP_ACCESS_NUM
+#define CFG_CPP_ACCESS_BOOL CFG_CPP_ACCESS_NUM
+#define CFG_CPP_ACCESS_BITS CFG_CPP_ACCESS_NUM
+#define CFG_CPP_ACCESS_FLOAT CFG_CPP_ACCESS_NUM
+#define CFG_CPP_ACCESS_STR(n, member) \
+    using type = std::remove_reference_t<decltype(std::declval<logger_config_t &>().member)>; \
+    using value_type = const char *; \
+    static value_type get(const logger_config_t &c) { return c.member; } \
+    static char *buf(logger_config_t &c) { return c.member; }
+// one bit of the flags byte named by member
+#define CFG_CPP_ACCESS_FLAG(n, member) \
+    using type = bool; \
+    using value_type = bool; \
+    static constexpr uint8_t mask = 1 << cfg_flag_##n; \
+    static value_type get(const logger_config_t &c) { return c.member & mask; } \
+    static void put(logger_config_t &c, type v) { c.member = v ? (c.member | mask) : (c.member & ~mask); }
+CFG_CALIBRATION_ITEM_LIST(CFG_CPP_TRAITS)
+CFG_GPS_ITEM_LIST(CFG_CPP_TRAITS)
+CFG_SCREEN_ITEM_LIST(CFG_CPP_TRAITS)
+CFG_SCREEN_ITEM_LIST_A(CFG_CPP_TRAITS)
+CFG_FW_UPDATE_ITEM_LIST(CFG_CPP_TRAITS)
+CFG_ITEM_LIST(CFG_CPP_TRAITS)
+#undef CFG_CPP_ACCESS_FLAG
+#undef CFG_CPP_ACCESS_STR
+#undef CFG_CPP_ACCESS_FLOAT
+#undef CFG_CPP_ACCESS_BITS
+#undef CFG_CPP_ACCESS_BOOL
+#undef CFG_CPP_ACCESS_INT
+#undef CFG_CPP_ACCESS_UINT
+#undef CFG_CPP_ACCESS_NUM
+#undef CFG_CPP_TRAITS_II
+#undef CFG_CPP_TRAITS_I
+#undef CFG_CPP_TRAITS
+
+template <field F> using value_t = typename traits<F>::value_type;
+
+/// published configuration held for the lifetime of the object, no config lock taken
+class snapshot {
+  public:
+    snapshot() : view_(config_view_acquire(&generation_)) {}
+    ~snapshot() {
+        if (view_)
+            config_view_release(view_);
+    }
+    snapshot(const snapshot &) = delete;
+    snapshot &operator=(const snapshot &) = delete;
+
+    explicit operator bool() const { return view_ != nullptr; }
+    const logger_config_t &operator*() const { return *view_; }
+    uint32_t generation() const { return generation_; }
+    /// a newer configuration was published since this one was taken
+    bool stale() const { return config_view_generation() != generation_; }
+
+  private:
+    uint32_t generation_ = 0;
+    const logger_config_t *view_;
+};
+
+/// config_txn_t, dropped unless committed
+class txn {
+  public:
+    txn(logger_config_t &config, uint8_t ublox_hw) { config_txn_begin(&txn_, &config, ublox_hw); }
+    ~txn() { config_txn_abort(&txn_); }
+    txn(const txn &) = delete;
+    txn &operator=(const txn &) = delete;
+
+    logger_config_t &staged() { return txn_.staged; }
+    const logger_config_t &staged() const { return txn_.staged; }
+    config_change_mask_t dirty() const { return txn_.changed; }
+    void mark(config_change_mask_t bits) { txn_.changed |= bits; }
+
+    esp_err_t commit() { return config_txn_commit(&txn_); }
+    void abort() { config_txn_abort(&txn_); }
+
+  private:
+    config_txn_t txn_;
+};
+
+template <field F> inline value_t<F> get(const logger_config_t &config) {
+    return traits<F>::get(config);
+}
+
+template <field F> inline value_t<F> get(const snapshot &snap) {
+    return traits<F>::get(*snap);
+}
+
+template <field F> inline value_t<F> get(const txn &t) {
+    return traits<F>::get(t.staged());
+}
+
+/// numbers are clamped to the item range, strings truncated, the dirty bit is set only on change
+template <field F, typename V> inline bool set(txn &t, V val) {
+    using T = traits<F>;
+    if constexpr (std::is_array<typename T::type>::value) {
+        char *dst = T::buf(t.staged());
+        const char *s = val;
+        size_t len = strnlen(s, sizeof(typename T::type) - 1);
+        if (!strncmp(dst, s, len) && dst[len] == 0)
+            return false;
+        memcpy(dst, s, len);
+        dst[len] = 0;
+    } else {
+        static_assert(std::is_arithmetic<V>::value, "numeric item needs a number");
+        double d = static_cast<double>(val);
+        auto v = static_cast<typename T::type>(d < T::min ? T::min : d > T::max ? T::max : d);
+        if (T::get(t.staged()) == v)
+            return false;
+        T::put(t.staged(), v);
+    }
+    t.mark(T::bit);
+    return true;
+}
+
+} // namespace cfg
+
+#endif /* A77DABC5_B5F9_4949_AD1A_7311107F98BC */
@@ -1,52 +1,143 @@
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
 
 #include "logger_config.h"
 #include "ubx.h"
 
 #include "json.h"
 #include "strbf.h"
-#include "vfs.h"
 #include "config_events.h"
 #include "logger_config_private.h"
-#include "vfs_fat_sdspi.h"
-#if defined(CONFIG_USE_FATFS)
-#include "vfs_fat_spiflash.h"
-#endif
+#include "config_fields.h"
+#include "config_json.h"
+#include "config_snapshot.h"
+#include "config_journal.h"
+#include "config_port.h"
 
 static const char *TAG = "config";
-SemaphoreHandle_t c_sem_lock = 0;
-#define CFG_FILE_NAME "config.txt";
-#define CFG_FILE_NAME_BACKUP "config.txt.bak";
-#define CFG_FILE_NAME_DEFAULT "default.json";
+#define CFG_FILE_NAME "config.txt"
+#define CFG_FILE_NAME_BACKUP "config.txt.bak"
+#define CFG_FILE_NAME_DEFAULT "default.json"
+#define CFG_FILE_NAME_SNAPSHOT "config.bin"
+#define CFG_FILE_NAME_SNAPSHOT_BACKUP "config.bin.bak"
+#define CFG_FILE_NAME_JOURNAL "config.log"
+#define CFG_PATH_MAX 64
 
 static const char * config_file_path = 0;
 static const char * config_file_backup_path = 0;
 static const char * config_file_default_path = 0;
+static const char * config_snapshot_path = 0;
+static const char * config_snapshot_backup_path = 0;
+static const char * config_journal_path = 0;
+static char config_path_buf[6][CFG_PATH_MAX];
+static logger_config_t * config_save_pending = 0;
+static uint8_t config_save_ublox_hw = 0;
+static portMUX_TYPE config_save_mux = portMUX_INITIALIZER_UNLOCKED; // pending save, marking one never waits for a save in progress
+// persistence stage, everything below is guarded by the store lock
+static logger_config_t config_persist_copy; // what is being written, storage never reads the live config
+static logger_config_t config_persisted; // content of the files after the last load or save
+static uint8_t config_persisted_valid = 0;
+static uint8_t config_mirror_stale = 0; // journal holds changes the text copy does not have yet
+static uint32_t config_text_crc = 0; // crc32 of the config.txt last written or looked at, kept in the snapshot header
+static uint8_t config_store_ublox_hw = 0; // receiver of the last save, for saves no caller asked for
+static int32_t config_save_event = -1; // save result, posted once the store lock is given back
+static logger_config_t config_base; // built-in defaults with default.json on top, saves hold only what differs
+#define CFG_JOURNAL_BATCH_MAX 4
+
+static inline void config_persisted_set(const logger_config_t *config) {
+    memcpy(&config_persisted, config, sizeof(config_persisted));
+    config_persisted_valid = 1;
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+    config_profile_track(config);
+#endif
+}
 
-ESP_EVENT_DEFINE_BASE(CONFIG_EVENT);
+#if defined(CONFIG_LOGGER_CONFIG_STORE_RAM)
+static const config_store_t *config_store = &config_store_ram;
+#elif defined(CONFIG_LOGGER_CONFIG_STORE_KV)
+static const config_store_t *config_store = &config_store_kv;
+#else
+static const config_store_t *config_store = &config_store_file;
+#endif
+
+static inline esp_err_t config_store_field(const logger_config_t *config, uint8_t item) {
+    return config_store->store_field ? config_store->store_field(config, item) : ESP_ERR_NOT_SUPPORTED;
+}
 
-#define SPEED_FIELD_ITEM_LIST(l) l(dynamic) l(stat_10_sec) l(stat_alpha) l(stat_1852_m) l(stat_dist_500m) l(stat_max_2s_10s) l(stat_half_hour) l(stat_1_hour) l(stat_1h_dynamic)
-#define STAT_SCREEN_ITEM_LIST(l) l(stat_10_sec) l(stat_2_sec) l(stat_250_m) l(stat_500_m) l(stat_1852_m) l(stat_a500) l(stat_avg_10sec) l(stat_stat1) l(stat_avg_a500)
+/// journal holds changes config.txt does not have yet, only the file store keeps a text copy
+static inline void config_mirror_mark(uint8_t ublox_hw) {
+#if defined(CONFIG_LOGGER_CONFIG_JSON_MIRROR)
+    if (config_store != &config_store_file)
+        return;
+    config_mirror_stale = 1;
+#endif
+    config_store_ublox_hw = ublox_hw;
+}
 
-#define BOARD_LOGO_ITEM_LIST(l) l(Starboard) l(Fanatic) l(JP) l(Patrik)
-#define SAIL_LOGO_ITEM_LIST(l) l(GASails) l(Duotone) l(NeilPryde) l(LoftSails) l(Gunsails) l(Point7) l(Patrik)
+static inline void config_store_sync(void) {
+    if (config_store->sync && config_store->sync() != ESP_OK)
+        ESP_LOGE(TAG, "[%s] %s failed", __func__, config_store->name);
+}
 
-#define SPEED_UNIT_ITEM_LIST(l) l(m/s) l(km/h) l(knots)
-#define SAMPLE_RATE_ITEM_LIST(l) l(1 Hz) l(5 Hz) l(10 Hz) l(16 Hz) l(20 Hz)
-#define SCREEN_ROTATION_ITEM_LIST(l) l(0_deg) l(90_deg) l(180_deg) l(270_deg)
-#define FW_UPDATE_CHANNEL_ITEM_LIST(l) l(stable) l(unstable)
+esp_err_t config_store_use(const config_store_t *store) {
+    if (!store || !store->load || !store->store)
+        return ESP_ERR_INVALID_ARG;
+    if (config_lock_ready())
+        config_store_lock(__func__);
+    config_store = store;
+    config_persisted_valid = 0; // nothing known about the new store
+    if (config_lock_ready())
+        config_store_unlock();
+    return ESP_OK;
+}
+
+/// store lock given back before the save event goes out, a full event loop only holds up the saving task
+void config_store_release(void) {
+    int32_t id = config_save_event;
+    config_save_event = -1;
+    config_store_unlock();
+    if (id < 0)
+        return;
+    // persist copy may be reused as soon as the lock is free, the published view stays put
+    const logger_config_t *view = config_view_acquire(0);
+    if (view)
+        config_post_event(id, view);
+    config_view_release(view);
+}
+
+/// consistent copy of the live config for the store, sections are held for the memcpy only, caller holds the store lock
+static logger_config_t *config_persist_capture(const logger_config_t *config) {
+    config_lock(__func__);
+    memcpy(&config_persist_copy, config, sizeof(config_persist_copy));
+    config_unlock();
+    return &config_persist_copy;
+}
+
+/// the view is a copy of the whole config, called after the section locks of the change are given back;
+/// the copy is taken under all sections, the view slot is only looked for once they are released
+static esp_err_t config_publish(const logger_config_t *config) {
+    config_lock(__func__);
+    config_view_stage(config);
+    config_unlock();
+    return config_view_commit();
+}
+
+#if (CONFIG_LOGGER_CONFIG_SAVE_DELAY_MS > 0)
+static TaskHandle_t config_save_task_handle = 0;
+#endif
+
+ESP_EVENT_DEFINE_BASE(CONFIG_EVENT);
 
-const char * const config_stat_screen_items[] = { STAT_SCREEN_ITEM_LIST(STRINGIFY) };
-const size_t config_stat_screen_item_count = sizeof(config_stat_screen_items) / sizeof(config_stat_screen_items[0]);
-const char * const config_speed_field_items[] = { SPEED_FIELD_ITEM_LIST(STRINGIFY) };
-const size_t config_speed_field_item_count = sizeof(config_speed_field_items) / sizeof(config_speed_field_items[0]);
 const char * const config_screen_items[] = { CFG_SCREEN_ITEM_LIST(STRINGIFY) CFG_SCREEN_ITEM_LIST_A(STRINGIFY) };
 const size_t config_screen_item_count = sizeof(config_screen_items) / sizeof(config_screen_items[0]);
 const char * const config_fw_update_items[] = { CFG_FW_UPDATE_ITEM_LIST(STRINGIFY) };
@@ -63,47 +154,124 @@ const char * const config_items[] = {
 };
 const size_t config_item_count = sizeof(config_items) / sizeof(config_items[0]);
 const char * config_item_names = ADD_QUOTE(CFG_CALIBRATION_ITEM_LIST(ADD) CFG_GPS_ITEM_LIST(ADD) CFG_SCREEN_ITEM_LIST(ADD) CFG_SCREEN_ITEM_LIST_A(ADD) CFG_FW_UPDATE_ITEM_LIST(ADD) CFG_ITEM_LIST(ADD));
-const char * config_item_names_compat = "Stat_screens|Stat_screens_time|GPIO12_screens|Board_Logo|board_Logo|sail_Logo|Sail_Logo|logTXT|logSBP|logUBX|logUBX_nav_sat|logGPY|logGPX|UBXfile|Sleep_info|";
 
-const char * const board_logos[] = {BOARD_LOGO_ITEM_LIST(STRINGIFY)};
-const char * const sail_logos[] = {SAIL_LOGO_ITEM_LIST(STRINGIFY)};
-const char * const speed_units[] = {SPEED_UNIT_ITEM_LIST(STRINGIFY)};
-const char * const sample_rates[] = {SAMPLE_RATE_ITEM_LIST(STRINGIFY)};
-const char * const screen_rotations[] = {SCREEN_ROTATION_ITEM_LIST(STRINGIFY)};
-const char * const channels[] = {FW_UPDATE_CHANNEL_ITEM_LIST(STRINGIFY)};
-const char * const not_set = "not set";
+static const uint8_t config_gps_item_ids[] = { CFG_GPS_ITEM_LIST(CFG_ENUM) };
+static const uint8_t config_screen_item_ids[] = { CFG_SCREEN_ITEM_LIST(CFG_ENUM) CFG_SCREEN_ITEM_LIST_A(CFG_ENUM) };
+static const uint8_t config_fw_update_item_ids[] = { CFG_FW_UPDATE_ITEM_LIST(CFG_ENUM) };
+
+// legacy spellings still accepted when reading older config files
+typedef struct config_item_alias_s {
+    const char *name;
+    uint8_t item;
+} config_item_alias_t;
+
+static const config_item_alias_t config_item_aliases[] = {
+    {"Stat_screens", cfg_stat_screens},
+    {"Stat_screens_time", cfg_stat_screens_time},
+    {"GPIO12_screens", cfg_gpio12_screens},
+    {"Board_Logo", cfg_board_logo},
+    {"board_Logo", cfg_board_logo},
+    {"sail_Logo", cfg_sail_logo},
+    {"Sail_Logo", cfg_sail_logo},
+    {"logTXT", cfg_log_txt},
+    {"logSBP", cfg_log_sbp},
+    {"logUBX", cfg_log_ubx},
+    {"logUBX_nav_sat", cfg_log_ubx_nav_sat},
+    {"logGPY", cfg_log_gpy},
+    {"logGPX", cfg_log_gpx},
+    {"UBXfile", cfg_ubx_file},
+    {"Sleep_info", cfg_sleep_info},
+};
 
-logger_config_item_t * get_fw_update_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item) {
-    assert(config);
-    if(!item) return 0;
-    item->name = config_fw_update_items[num];
-    item->pos = num;
-    if(!strcmp(item->name, config_items[cfg_update_channel])) {
-        item->value = config->fwupdate.channel;
-        item->desc = channels[config->fwupdate.channel];
+// open addressing name table, slot holds index+1 into config_items followed by config_item_aliases
+#define CFG_NAME_SLOTS 128
+static uint8_t config_name_slots[CFG_NAME_SLOTS] = {0};
+static uint8_t config_name_slots_ready = 0;
+
+static inline uint32_t config_name_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (const char *e = s + len; s < e; s++) {
+        h ^= (uint8_t)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline const char *config_name_at(uint8_t idx) {
+    return idx < config_item_count ? config_items[idx] : config_item_aliases[idx - config_item_count].name;
+}
+
+static void config_name_slots_build(void) {
+    _Static_assert(lengthof(config_items) + lengthof(config_item_aliases) < CFG_NAME_SLOTS / 2, "config name table too small");
+    memset(config_name_slots, 0, sizeof(config_name_slots));
+    for (uint8_t i = 0, j = config_item_count + lengthof(config_item_aliases); i < j; i++) {
+        const char *name = config_name_at(i);
+        uint32_t h = config_name_hash(name, strlen(name)) & (CFG_NAME_SLOTS - 1);
+        while (config_name_slots[h])
+            h = (h + 1) & (CFG_NAME_SLOTS - 1);
+        config_name_slots[h] = i + 1;
     }
-    else if(!strcmp(item->name, config_items[cfg_update_enabled])) {
-        item->value = config->fwupdate.update_enabled;
-        item->desc = config->fwupdate.update_enabled ? "yes" : "no";
+    config_name_slots_ready = 1;
+}
+
+/// resolve name of len chars to config_item_t, -1 when unknown, *alias set for legacy spelling
+int config_item_find(const char *name, size_t len, uint8_t *alias) {
+    if (!name)
+        return -1;
+    if (!config_name_slots_ready)
+        config_name_slots_build();
+    for (uint32_t h = config_name_hash(name, len) & (CFG_NAME_SLOTS - 1); config_name_slots[h]; h = (h + 1) & (CFG_NAME_SLOTS - 1)) {
+        uint8_t idx = config_name_slots[h] - 1;
+        const char *n = config_name_at(idx);
+        if (!strncmp(n, name, len) && n[len] == 0) {
+            if (alias)
+                *alias = idx >= config_item_count;
+            return idx < config_item_count ? idx : config_item_aliases[idx - config_item_count].item;
+        }
+    }
+    return -1;
+}
+
+int config_item_lookup(const char *name) {
+    return name ? config_item_find(name, strlen(name), 0) : -1;
+}
+
+static logger_config_item_t * config_menu_item(const logger_config_t *config, int id, int num, logger_config_item_t *item) {
+    const config_field_t *f = &config_fields[id];
+    item->name = f->name;
+    item->pos = num;
+    item->value = config_field_get_int(f, config);
+    if (f->type == CFG_T_BITS) {
+        item->desc = f->unset;
+    } else if (f->type == CFG_T_BOOL && !f->menu) {
+        item->value = item->value ? 1 : 0;
+        item->desc = item->value ? "on" : "off";
+    } else {
+        const char *desc = config_field_label(f, item->value, 1);
+        item->desc = desc ? desc : f->unset ? f->unset : not_set;
     }
     return item;
 }
 
+logger_config_item_t * get_fw_update_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item) {
+    assert(config);
+    if(!item) return 0;
+    if(num<0 || num>=config_fw_update_item_count) return item;
+    return config_menu_item(config, config_fw_update_item_ids[num], num, item);
+}
+
 int set_fw_update_cfg_item(logger_config_t * config, int num, uint8_t ublox_hw) {
     assert(config);
-    if(num>=2) return 0;
-    const char *name = config_fw_update_items[num];
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
-    uint16_t val = config->fwupdate.channel;
-    if(!strcmp(name, config_items[cfg_update_channel])) {
-        if(config->fwupdate.channel == 1) config->fwupdate.channel = 0;
-        else config->fwupdate.channel++;
-    }
-    else if(!strcmp(name, config_items[cfg_update_enabled])) {
-        config->fwupdate.update_enabled = config->fwupdate.update_enabled ? 0 : 1;
-    }
-    config_save_json(config, ublox_hw);
-    xSemaphoreGive(c_sem_lock);
+    if(num<0 || num>=config_fw_update_item_count) return 0;
+    int64_t start = config_metric_start();
+    config_change_mask_t bit = 1ULL << config_fw_update_item_ids[num];
+    config_lock_items(__func__, bit);
+    config_field_step(&config_fields[config_fw_update_item_ids[num]], config);
+    config_unlock_items(bit);
+    config_publish(config);
+    config_notify();
+    config_save_later(config, ublox_hw);
+    config_metric_end(cfg_metric_set, start);
     return 1;
 }
 
@@ -122,275 +290,69 @@ logger_config_item_t * get_stat_screen_cfg_item(const logger_config_t *config, i
 int set_stat_screen_cfg_item(logger_config_t * config, int num, uint8_t ublox_hw) {
     assert(config);
     if(num>=config_stat_screen_item_count) return 0;
+    int64_t start = config_metric_start();
     //const char *name = config_gps_items[num];
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
+    config_lock_items(__func__, 1ULL << cfg_stat_screens);
     uint16_t val = config->screen.stat_screens;
     ESP_LOGI(TAG, "[%s]: %d stat_screens:%hu", __func__, num, val);
     if(num>=0 && num<config_stat_screen_item_count) {
         val ^= (1 << num);
     }
     ESP_LOGI(TAG, "[%s] set stat_screens:%hu", __func__, val);
-    if(val!=config->screen.stat_screens) {
+    uint8_t changed = val!=config->screen.stat_screens;
+    if(changed)
         config->screen.stat_screens = val;
-        config_save_json(config, ublox_hw);
+    config_unlock_items(1ULL << cfg_stat_screens);
+    if(changed) {
+        config_publish(config);
+        config_notify();
+        config_save_later(config, ublox_hw);
     }
-    xSemaphoreGive(c_sem_lock);
+    config_metric_end(cfg_metric_set, start);
     return 1;
 }
 logger_config_item_t * get_screen_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item) {
     assert(config);
     if(!item) return 0;
-    item->name = config_screen_items[num];
-    item->pos = num;
-    if(!strcmp(item->name, config_items[cfg_speed_field])) {
-        item->value = config->screen.speed_field;
-        if(config->screen.speed_field > 0 && config->screen.speed_field <= config_speed_field_item_count)
-            item->desc = config_speed_field_items[config->screen.speed_field-1];
-        else
-            item->desc = not_set;
-    } else if(!strcmp(item->name, config_items[cfg_stat_screens_time])) {
-        item->value = config->screen.stat_screens_time;
-        if(item->value <= 1)
-            item->desc = "1 sec";
-        else if(item->value == 2)
-            item->desc = "2 sec";
-        else if(item->value == 3)
-            item->desc = "3 sec";
-        else if(item->value == 4)
-            item->desc = "4 sec";
-        else if(item->value >= 5)
-            item->desc = "5 sec";
-    } else if(!strcmp(item->name, config_items[cfg_stat_screens])) {
-        item->value = config->screen.stat_screens;
-        item->desc = "menu";
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-    } else if(!strcmp(item->name, config_items[cfg_screen_move_offset])) {
-        item->value = config->screen_move_offset ? 1 : 0;
-        item->desc = config->screen_move_offset ? "on" : "off";
-#else
-    } else if(!strcmp(item->name, config_items[cfg_screen_brightness])) {
-        item->value = config->screen_brightness;
-        item->desc = item->value <= 20 ? "20" : item->value <= 40 ? "40" : item->value <= 60 ? "60" : item->value == 80 ? "80" : "100" ;
-#endif
-    } else if(!strcmp(item->name, config_items[cfg_board_logo])) {
-        item->value = config->screen.board_logo;
-        if(config->screen.board_logo > 0 && config->screen.board_logo <= lengthof(board_logos))
-            item->desc = board_logos[config->screen.board_logo-1];
-        else
-            item->desc = not_set;
-    } else if(!strcmp(item->name, config_items[cfg_sail_logo])) {
-        item->value = config->screen.sail_logo;
-        if(config->screen.sail_logo > 0 && config->screen.sail_logo <= lengthof(sail_logos))
-            item->desc = sail_logos[config->screen.sail_logo-1];
-        else
-            item->desc = not_set;
-    }
-    else if(!strcmp(item->name, config_items[cfg_screen_rotation])) {
-        item->value = config->screen.screen_rotation;
-        if(config->screen.screen_rotation >=0 && config->screen.screen_rotation <= 3)
-            item->desc = screen_rotations[config->screen.screen_rotation];
-        else
-            item->desc = not_set;
-    }
-    return item;
+    if(num<0 || num>=config_screen_item_count) return item;
+    return config_menu_item(config, config_screen_item_ids[num], num, item);
 }
 
 int set_screen_cfg_item(logger_config_t * config, int num, uint8_t ublox_hw) {
     assert(config);
-    if(num>=config_screen_item_count) return 0;
-    const char *name = config_screen_items[num];
-    int ret = 0;
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
-    if(!strcmp(name, config_items[cfg_speed_field])) {
-        if(config->screen.speed_field == 9) config->screen.speed_field = 1;
-        else config->screen.speed_field++;
-        ret = cfg_speed_field;
-    } else if(!strcmp(name, config_items[cfg_stat_screens_time])) {
-        if(config->screen.stat_screens_time == 5) config->screen.stat_screens_time = 4;
-        else if(config->screen.stat_screens_time == 4) config->screen.stat_screens_time = 3;
-        else if(config->screen.stat_screens_time == 3) config->screen.stat_screens_time = 2;
-        else if(config->screen.stat_screens_time == 2) config->screen.stat_screens_time = 1;
-        else config->screen.stat_screens_time = 5;
-        ret = cfg_stat_screens_time;
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-    } else if (!strcmp(name, config_items[cfg_screen_move_offset])) {
-        config->screen_move_offset = config->screen_move_offset ? 0 : 1;
-        ret = cfg_screen_move_offset;
-#else
-    } else if (!strcmp(name, config_items[cfg_screen_brightness])) {
-        if(config->screen_brightness == 100) config->screen_brightness = 80;
-        else if(config->screen_brightness == 80) config->screen_brightness = 60;
-        else if(config->screen_brightness == 60) config->screen_brightness = 40;
-        else if(config->screen_brightness == 40) config->screen_brightness = 20;
-        else config->screen_brightness = 100;
-        ret = cfg_screen_brightness;
-#endif
-    } else if(!strcmp(name, config_items[cfg_board_logo])) {
-        if(config->screen.board_logo >= 11) config->screen.board_logo = 1;
-        else config->screen.board_logo++;
-        ret = cfg_board_logo;
-    } else if(!strcmp(name, config_items[cfg_sail_logo])) {
-        if(config->screen.sail_logo >= 12) config->screen.sail_logo = 1;
-        else config->screen.sail_logo++;
-        ret = cfg_sail_logo;
-    }
-    else if(!strcmp(name, config_items[cfg_screen_rotation])) {
-        if(config->screen.screen_rotation >= 3) {
-            config->screen.screen_rotation = 0;
-        }
-        else {
-            config->screen.screen_rotation++;
-        }
-        ret = cfg_screen_rotation;
-    }
-    config_save_json(config, ublox_hw);
-    xSemaphoreGive(c_sem_lock);
-    return ret;
+    if(num<0 || num>=config_screen_item_count) return 0;
+    int64_t start = config_metric_start();
+    const config_field_t *f = &config_fields[config_screen_item_ids[num]];
+    config_change_mask_t bit = 1ULL << config_screen_item_ids[num];
+    config_lock_items(__func__, bit);
+    config_field_step(f, config);
+    config_unlock_items(bit);
+    config_publish(config);
+    config_notify();
+    config_save_later(config, ublox_hw);
+    config_metric_end(cfg_metric_set, start);
+    return f->step ? config_screen_item_ids[num] : 0;
 }
 
 logger_config_item_t * get_gps_cfg_item(const logger_config_t *config, int num, logger_config_item_t *item) {
     assert(config);
     if(!item) return 0;
-    item->name = config_gps_items[num];
-    item->pos = num;
-    if (!strcmp(item->name, config_items[cfg_gnss])) {
-        item->value = config->gps.gnss;
-        if(config->gps.gnss == 111) {
-            item->desc = "G + E + B + R";
-        }
-        else if(config->gps.gnss == 107) {
-            item->desc = "G + B + R";
-        }
-        else if(config->gps.gnss == 103) {
-            item->desc = "G + E + R";
-        }
-        else if(config->gps.gnss == 47) {
-            item->desc = "G + E + B";
-        }
-        else if(config->gps.gnss == 99) {
-            item->desc = "G + R";
-        }
-        else if(config->gps.gnss == 43) {
-            item->desc = "G + B";
-        }
-        else if(config->gps.gnss == 39) {
-            item->desc = "G + E";
-        }
-        else {
-            item->desc = not_set;
-        }
-    } else if (!strcmp(item->name, config_items[cfg_sample_rate])) {
-        item->value = config->gps.sample_rate;
-        if(config->gps.sample_rate == 1) {
-            item->desc = sample_rates[0];
-        }
-        else if(config->gps.sample_rate == 16) {
-            item->desc = sample_rates[3];
-        }
-        else if(config->gps.sample_rate%5 == 0 && config->gps.sample_rate <= 20) {
-            item->desc = sample_rates[config->gps.sample_rate/5];
-        }
-        else {
-            item->desc = not_set;
-        }
-    } else if (!strcmp(item->name, config_items[cfg_timezone])) {
-        item->value = config->timezone;
-        if(config->timezone == 1) {
-            item->desc = "UTC+1";
-        }
-        else if(config->timezone == 2) {
-            item->desc = "UTC+2";
-        }
-        else if(config->timezone == 3) {
-            item->desc = "UTC+3";
-        }
-        else {
-            item->desc = "UTC";
-        }
-    } else if (!strcmp(item->name, config_items[cfg_speed_unit])) {
-        item->value = config->gps.speed_unit;
-        item->desc = speed_units[config->gps.speed_unit];
-    } else if (!strcmp(item->name, config_items[cfg_log_txt])) {
-        item->value = config->gps.log_txt ? 1 : 0;
-        item->desc = config->gps.log_txt ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_log_ubx])) {
-        item->value = config->gps.log_ubx ? 1 : 0;
-        item->desc = config->gps.log_ubx ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_log_sbp])) {
-        item->value = config->gps.log_sbp ? 1 : 0;
-        item->desc = config->gps.log_sbp ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_log_gpy])) {
-        item->value = config->gps.log_gpy ? 1 : 0;
-        item->desc = config->gps.log_gpy ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_log_gpx])) {
-        item->value = config->gps.log_gpx ? 1 : 0;
-        item->desc = config->gps.log_gpx ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_log_ubx_nav_sat])) {
-        item->value = config->gps.log_ubx_nav_sat ? 1 : 0;
-        item->desc = config->gps.log_ubx_nav_sat ? "on" : "off";
-    } else if (!strcmp(item->name, config_items[cfg_dynamic_model])) {
-        item->value = config->gps.dynamic_model;
-        if(config->gps.dynamic_model == 1) {
-            item->desc = "sea";
-        }
-        else if(config->gps.dynamic_model == 2) {
-            item->desc = "automotive";
-        }
-        else {
-            item->desc = "portable";
-        }
-    }
-    return item;
+    if(num<0 || num>=config_gps_item_count) return item;
+    return config_menu_item(config, config_gps_item_ids[num], num, item);
 }
 
 int set_gps_cfg_item(logger_config_t *config, int num, uint8_t ublox_hw) {
     assert(config);
-    if(num>=config_gps_item_count) return 0;
-    const char *name = config_gps_items[num];
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
-    if (!strcmp(name, "gnss")) {
-        if(config->gps.gnss == 111) config->gps.gnss = 107;
-        else if(config->gps.gnss == 107) config->gps.gnss = 103;
-        else if(config->gps.gnss == 103) config->gps.gnss = 47;
-        else if(config->gps.gnss == 47) config->gps.gnss = 99;
-        else if(config->gps.gnss == 99) config->gps.gnss = 43;
-        else if(config->gps.gnss == 43) config->gps.gnss = 39;
-        else if(config->gps.gnss == 39) config->gps.gnss = 111;
-        else config->gps.gnss = 111;
-    } else if (!strcmp(name, config_items[cfg_sample_rate])) {
-        if(config->gps.sample_rate == 5) config->gps.sample_rate = 1;
-        else if(config->gps.sample_rate == 10) config->gps.sample_rate = 5;
-        else if(config->gps.sample_rate == 16) config->gps.sample_rate = 10;
-        else if(config->gps.sample_rate == 20) config->gps.sample_rate = 16;
-        else config->gps.sample_rate = 20;
-    } else if (!strcmp(name, "timezone")) {
-        if(config->timezone == 1) config->timezone = 2;
-        else if(config->timezone == 2) config->timezone = 3;
-        else if(config->timezone == 3) config->timezone = 1;
-        else config->timezone = 1;
-   } else if (!strcmp(name, config_items[cfg_speed_unit])) {
-        if(config->gps.speed_unit == 1) config->gps.speed_unit = 0;
-        else if(config->gps.speed_unit == 2) config->gps.speed_unit = 1;
-        else  config->gps.speed_unit = 2;
-    } else if (!strcmp(name, config_items[cfg_log_txt])) {
-        config->gps.log_txt = config->gps.log_txt ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_log_ubx])) {
-        config->gps.log_ubx = config->gps.log_ubx ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_log_sbp])) {
-        config->gps.log_sbp = config->gps.log_sbp ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_log_gpy])) {
-        config->gps.log_gpy = config->gps.log_gpy ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_log_gpx])) {
-        config->gps.log_gpx = config->gps.log_gpx ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_log_ubx_nav_sat])) {
-        config->gps.log_ubx_nav_sat = config->gps.log_ubx_nav_sat ? 0 : 1;
-    } else if (!strcmp(name, config_items[cfg_dynamic_model])) {
-        if(config->gps.dynamic_model == 0) config->gps.dynamic_model = 2;
-        else if(config->gps.dynamic_model == 2) config->gps.dynamic_model = 1;
-        else config->gps.dynamic_model = 0;
-    }
-    config_save_json(config, ublox_hw);
-    xSemaphoreGive(c_sem_lock);
+    if(num<0 || num>=config_gps_item_count) return 0;
+    int64_t start = config_metric_start();
+    config_change_mask_t bit = 1ULL << config_gps_item_ids[num];
+    config_lock_items(__func__, bit);
+    config_field_step(&config_fields[config_gps_item_ids[num]], config);
+    config_unlock_items(bit);
+    config_publish(config);
+    config_notify();
+    config_save_later(config, ublox_hw);
+    config_metric_end(cfg_metric_set, start);
     return 1;
 }
 
@@ -399,65 +361,104 @@ logger_config_t *config_new() {
     return config_init(c);
 }
 
+static void config_screen_cb_adapter(config_change_mask_t changed, const logger_config_t *view, void *ctx) {
+    const logger_config_t *config = ctx;
+    for (; changed && config->config_changed_screen_cb; changed &= changed - 1)
+        config->config_changed_screen_cb(config_items[__builtin_ctzll(changed)]);
+}
+
 esp_err_t config_set_screen_cb(logger_config_t * config, void(*cb)(const char *)) {
     if(!config) return ESP_ERR_INVALID_ARG;
     config->config_changed_screen_cb = cb;
-    return ESP_OK;
+    config_unsubscribe(config->config_changed_screen_sub - 1);
+    int handle = cb ? config_subscribe(~0ULL, config_screen_cb_adapter, config) : -1;
+    config->config_changed_screen_sub = handle + 1;
+    return handle < 0 && cb ? ESP_ERR_NO_MEM : ESP_OK;
 }
 
 void config_delete(logger_config_t *config) {
+    if (config)
+        config_unsubscribe(config->config_changed_screen_sub - 1);
     free(config);
 }
 
+static const char *config_path_set(uint8_t i, const char *dir, const char *name) {
+    snprintf(config_path_buf[i], CFG_PATH_MAX, "%s/%s", dir, name);
+    return config_path_buf[i];
+}
+
+static esp_err_t config_decode_file(logger_config_t *config, const char *path);
+
+/// defaults layer, the site file is optional and may set any subset of the items
+static void config_base_build(void) {
+    logger_config_t cf = LOGGER_CONFIG_DEFAULTS();
+    memcpy(&config_base, &cf, sizeof(config_base));
+    if (config_file_default_path && config_decode_file(&config_base, config_file_default_path) == ESP_OK)
+        ILOG(TAG, "[%s] site defaults from %s", __func__, config_file_default_path);
+}
+
 logger_config_t *config_init(logger_config_t *config) {
     logger_config_t cf = LOGGER_CONFIG_DEFAULTS();
     memcpy(config, &cf, sizeof(logger_config_t));
-    if(!c_sem_lock)
-        c_sem_lock = xSemaphoreCreateRecursiveMutex();
-    if(sdcard_is_mounted()) {
-        config_file_path = CONFIG_SD_MOUNT_POINT"/"CFG_FILE_NAME;
-        config_file_backup_path = CONFIG_SD_MOUNT_POINT"/"CFG_FILE_NAME_BACKUP;
-        config_file_default_path = CONFIG_SD_MOUNT_POINT"/"CFG_FILE_NAME_DEFAULT;
-    } else 
-#if defined(CONFIG_USE_FATFS)
-    if(fatfs_is_mounted()) { // first choice is internal fat partition
-        config_file_path = CONFIG_FATFS_MOUNT_POINT"/"CFG_FILE_NAME;
-        config_file_backup_path = CONFIG_FATFS_MOUNT_POINT"/"CFG_FILE_NAME_BACKUP;
-        config_file_default_path = CONFIG_FATFS_MOUNT_POINT"/"CFG_FILE_NAME_DEFAULT;
-    } else 
-#endif
-#if defined(CONFIG_USE_LITTLEFS)
-    if(littlefs_is_mounted()) {
-        config_file_path = CONFIG_LITTLEFS_MOUNT_POINT"/"CFG_FILE_NAME;
-        config_file_backup_path = CONFIG_LITTLEFS_MOUNT_POINT"/"CFG_FILE_NAME_BACKUP;
-        config_file_default_path = CONFIG_LITTLEFS_MOUNT_POINT"/"CFG_FILE_NAME_DEFAULT;
-    } else 
-#endif
-    {
+    config_lock_init();
+    const char *dir = config_port_dir();
+    if(!dir && config_store == &config_store_file) {
         ESP_LOGE(TAG, "No filesystem mounted");
         return 0;
     }
-    esp_event_post(CONFIG_EVENT, LOGGER_CONFIG_EVENT_CONFIG_INIT_DONE, config, sizeof(logger_config_t), portMAX_DELAY);
+    if(dir) {
+        config_file_path = config_path_set(0, dir, CFG_FILE_NAME);
+        config_file_backup_path = config_path_set(1, dir, CFG_FILE_NAME_BACKUP);
+        config_file_default_path = config_path_set(2, dir, CFG_FILE_NAME_DEFAULT);
+        config_snapshot_path = config_path_set(3, dir, CFG_FILE_NAME_SNAPSHOT);
+        config_snapshot_backup_path = config_path_set(4, dir, CFG_FILE_NAME_SNAPSHOT_BACKUP);
+        config_journal_path = config_path_set(5, dir, CFG_FILE_NAME_JOURNAL);
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+        config_profile_init(dir);
+#endif
+    }
+    config_base_build();
+    config_defaults(config);
+    config_view_publish(config);
+    config_notify();
+    config_post_event(LOGGER_CONFIG_EVENT_CONFIG_INIT_DONE, config);
     return config;
 }
 
 void config_deinit(logger_config_t *config) {
-    if(c_sem_lock){
-        vSemaphoreDelete(c_sem_lock);
-        c_sem_lock = 0;
+#if (CONFIG_LOGGER_CONFIG_CMD_QUEUE_LEN > 0)
+    config_service_stop();
+#endif
+    config_flush();
+#if (CONFIG_LOGGER_CONFIG_SAVE_DELAY_MS > 0)
+    if(config_save_task_handle) {
+        vTaskDelete(config_save_task_handle);
+        config_save_task_handle = 0;
     }
+#endif
+    config_view_deinit();
+    config_lock_deinit();
 }
 
 logger_config_t *config_defaults(logger_config_t *config) {
     ILOG(TAG,"[%s]",__func__);
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        const config_field_t *f = &config_fields[i];
+        config_field_copy(f, config, &config_base);
+    }
     return config;
 }
 
+config_change_mask_t config_overrides(const logger_config_t *config) {
+    return config_diff(&config_base, config);
+}
+
 logger_config_t *config_clone(logger_config_t *orig, logger_config_t *config) {
     ILOG(TAG,"[%s]",__func__);
     if (!orig || !config)
         return config;
     memcpy(config, orig, sizeof(logger_config_t));
+    config->config_changed_screen_sub = 0; // the subscription stays with orig
     return config;
 }
 
@@ -476,6 +477,9 @@ JsonNode *config_parse(const char *json) {
     return root;
 }
 
+static int config_set_item(logger_config_t *config, int item, const JsonNode *value, const char *var, uint8_t force);
+static esp_err_t config_save_full(logger_config_t *config, uint8_t ublox_hw, config_save_trigger_t trigger);
+
 int config_set(logger_config_t *config, JsonNode *root, const char *str, uint8_t force) {
 #if (CONFIG_LOGGER_CONFIG_LOG_LEVEL < 2)
     ILOG(TAG,"[%s] name: %s",__func__, str ? str : "-");
@@ -483,7 +487,6 @@ int config_set(logger_config_t *config, JsonNode *root, const char *str, uint8_t
     if (!root) {
         return -1;
     }
-    int8_t changed = -1;
     JsonNode *name = 0, *value = 0;
     const char *var = 0;
     if (!str) {
@@ -503,7 +506,8 @@ int config_set(logger_config_t *config, JsonNode *root, const char *str, uint8_t
 #endif
         goto err;
     }
-    if (!strstr(config_item_names, var) && !strstr(config_item_names_compat, var)) {
+    int item = config_item_lookup(var);
+    if (item < 0) {
 #if CONFIG_LOGGER_CONFIG_LOG_LEVEL < 3
         printf("[%s] ! in names\n", __FUNCTION__);
 #endif
@@ -519,418 +523,42 @@ int config_set(logger_config_t *config, JsonNode *root, const char *str, uint8_t
         DLOG(TAG, "[%s] {name: ( %s | %s )}\n", __FUNCTION__, (name && name->data.string_ ? name->data.string_ : "-"), (str ? str : "-"));
     if (value)
         DLOG(TAG, "[%s] {value: ( %s | %f ), key: %s}\n", __FUNCTION__, (value->tag == JSON_STRING ? value->data.string_ : "-"), (value->tag == JSON_NUMBER ? value->data.number_ : 0), (value->key ? value->key : "-"));
+    int64_t start = config_metric_start();
+    int ret = config_set_item(config, item, value, var, force);
+    config_metric_end(cfg_metric_set, start);
+    config_notify();
+    return ret;
+err:
+    ESP_LOGW(TAG, "[%s] error: %s %d", __FUNCTION__, var ? var : "-", value ? value->tag : -1);
+    return -2;
+}
 
-#ifdef USE_CUSTOM_CALIBRATION_VAL
-    if (!strcmp(var, config_items[cfg_cal_bat])) {  // calibration for read out bat voltage
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        float val = value->data.number_;
-        if (force || val != config->cal_bat) {
-            config->cal_bat = value->data.number_;
-            if (!str) {
-                if (m_context_rtc.RTC_calibration_bat != config->cal_bat)
-                    m_context_rtc.RTC_calibration_bat = config->cal_bat;
-            }
-            changed = 1;
-        }
-
-    } else 
-#endif
-    if (!strcmp(var, config_items[cfg_speed_unit])) {  // conversion m/s to km/h, for knots use 1.944
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        float val = value->data.number_;
-        if (force || val != config->gps.speed_unit) {
-            config->gps.speed_unit = val;
-            changed = cfg_speed_unit;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_sample_rate])) {  // gps_rate in Hz, 1, 5 or 10Hz !!!
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.sample_rate) {
-            config->gps.sample_rate = val;
-            changed = cfg_sample_rate;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_gnss])) {  // default setting 2 GNSS, GPS & GLONAS
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.gnss) {
-            config->gps.gnss = val;
-            changed = cfg_gnss;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_speed_field])) {  // choice for first field in speed screen !!!
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.speed_field) {
-            config->screen.speed_field = val;
-            changed = cfg_speed_field;
-        }
-
-    }
-
-    else if (!strcmp(var, config_items[cfg_speed_large_font])) {  // fonts on the first line are bigger, actual speed
-        // font is smaller
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.speed_large_font) {
-            config->screen.speed_large_font = val;
-            changed = cfg_speed_large_font;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_dynamic_model])) {  // choice for dynamic model "Sea",if 0 model "portable"
-        // is used !!
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.dynamic_model) {
-            config->gps.dynamic_model = val;
-            changed = cfg_dynamic_model;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_timezone])) {  // choice for timedifference in hours with UTC, for Belgium
-        // 1 or 2 (summertime)
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        float val = value->data.number_;
-        if (force || val != config->timezone) {
-            config->timezone = val;
-            changed = cfg_timezone;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_stat_screens]) || !strcmp(var, "Stat_screens")) {  // choice for stats field when no speed, here stat_screen
-        // 1, 2 and 3 will be active
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint32_t val = value->data.number_;
-        if (force || val != config->screen.stat_screens) {
-            config->screen.stat_screens = val;
-            changed = cfg_stat_screens;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_stat_screens_time]) || !strcmp(var, "Stat_screens_time")) {  // time between switching stat_screens
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.stat_screens_time) {
-            config->screen.stat_screens_time = val;
-            changed = cfg_stat_screens_time;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_gpio12_screens]) || !strcmp(var, "GPIO12_screens")) {  // choice for stats field when gpio12 is activated
-        // (pull-up high, low = active)
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint32_t val = value->data.number_;
-        if (force || val != config->screen.gpio12_screens) {
-            config->screen.gpio12_screens = val;
-            changed = cfg_gpio12_screens;
-        }
-
-    // } else if (!strcmp(var, "stat_screens_persist")) {  // choice for stats field when no speed, here
-    //     // stat_screen 1, 2 and 3 will be active / for
-    //     // resave the config
-    //     if (!value || value->tag != JSON_NUMBER) {
-    //         goto err;
-    //     }
-    //     uint8_t val = value->data.number_;
-    //     if (force || val != config->screen.stat_screens_persist) {
-    //         config->screen.stat_screens_persist = val;
-    //         changed = 1;
-    //     }
-
-    // } else if (!strcmp(var, "gpio12_screens_persist")) {  // choice for stats field when gpio12 is
-    //     // activated (pull-up high, low = active) / for
-    //     // resave the config
-    //     if (!value || value->tag != JSON_NUMBER) {
-    //         goto err;
-    //     }
-    //     uint8_t val = value->data.number_;
-    //     if (force || val != config->screen.gpio12_screens_persist) {
-    //         config->screen.gpio12_screens_persist = val;
-    //         changed = 1;
-    //     }
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-    } else if (!strcmp(var, config_items[cfg_screen_move_offset])) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen_move_offset) {
-            config->screen_move_offset = val;
-            changed = cfg_screen_move_offset;
-        }
-#else
-    } else if (!strcmp(var, config_items[cfg_screen_brightness])) {  // max speed in m/s for showing Stat screens
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen_brightness) {
-            config->screen_brightness = val;
-            changed = cfg_screen_brightness;
-        }
-#endif
-    } else if (!strcmp(var, config_items[cfg_file_date_time])) {
-    } else if (!strcmp(var, config_items[cfg_board_logo]) || !strcmp(var, "board_Logo") || !strcmp(var, "Board_Logo")) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.board_logo) {
-            config->screen.board_logo = val;
-            changed = cfg_board_logo;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_sail_logo]) || !strcmp(var, "sail_Logo") || !strcmp(var, "Sail_Logo")) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.sail_logo) {
-            config->screen.sail_logo = val;
-            changed = cfg_sail_logo;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_stat_speed])) {  // max speed in m/s for showing Stat screens
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.stat_speed) {
-            config->screen.stat_speed = val;
-            changed = cfg_stat_speed;
-        }
-    } else if (!strcmp(var, config_items[cfg_bar_length])) {  // choice for bar indicator for length of run in m
-        // (nautical mile)
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint16_t val = value->data.number_;
-        if (force || val != config->bar_length) {
-            config->bar_length = val;
-            changed = cfg_bar_length;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_archive_days])) {  // how many days files will be moved to the "Archive" dir
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint16_t val = value->data.number_;
-        if (force || val != config->archive_days) {
-            config->archive_days = val;
-            changed = cfg_archive_days;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_update_enabled])) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->fwupdate.update_enabled) {
-            config->fwupdate.update_enabled = val;
-            changed = cfg_update_enabled;
-        }
-    } else if (!strcmp(var, config_items[cfg_update_channel])) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->fwupdate.channel) {
-            config->fwupdate.channel = val;
-            changed = cfg_update_channel;
-        }
-    } else if (!strcmp(var, config_items[cfg_log_txt]) || !strcmp(var, "logTXT")) {  // switchinf off .txt files
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_txt) {
-            config->gps.log_txt = val;
-            changed = cfg_log_txt;
-        }
-    } else if (!strcmp(var, config_items[cfg_log_ubx]) || !strcmp(var, "logUBX")) {  // log to .ubx
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_ubx) {
-            config->gps.log_ubx = val;
-            changed = cfg_log_ubx;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_log_ubx_nav_sat]) || !strcmp(var, "logUBX_nav_sat")) {  // log nav sat msg to .ubx
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_ubx_nav_sat) {
-            config->gps.log_ubx_nav_sat = val;
-            changed = cfg_log_ubx_nav_sat;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_log_sbp]) || !strcmp(var, "logSBP")) {  // log to .sbp
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_sbp) {
-            config->gps.log_sbp = val;
-            changed = cfg_log_sbp;
-        }
-
-    } else if (!strcmp(var, config_items[cfg_log_gpy]) || !strcmp(var, "logGPY")) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_gpy) {
-            config->gps.log_gpy = val;
-            changed = cfg_log_gpy;
-        }
-
-    }  // log to .gps
-    else if (!strcmp(var, config_items[cfg_log_gpx]) || !strcmp(var, "logGPX")) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->gps.log_gpx) {
-            config->gps.log_gpx = val;
-            changed = cfg_log_gpx;
-        }
-
-    }  // log to .gpx
-    else if (!strcmp(var, config_items[cfg_file_date_time])) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->file_date_time) {
-            config->file_date_time = val;
-            changed = cfg_file_date_time;
-        }
-
+/// 1 when changed, 0 when unchanged, -1 when the value does not fit the item type
+static int config_set_value(const config_field_t *f, logger_config_t *config, const JsonNode *value, uint8_t force) {
+    if (f->type == CFG_T_STR) {
+        if (value->tag != JSON_STRING)
+            return -1;
+        return config_field_set_str(f, config, value->data.string_, strlen(value->data.string_), force);
+    } else if (value->tag == JSON_NUMBER) {
+        return config_field_set_num(f, config, value->data.number_, force);
+    } else if (value->tag == JSON_BOOL && f->type == CFG_T_BOOL) {
+        return config_field_set_num(f, config, value->data.bool_, force);
     }
-    else if (!strcmp(var, config_items[cfg_screen_rotation])) {
-        if (!value || value->tag != JSON_NUMBER) {
-            goto err;
-        }
-        uint8_t val = value->data.number_;
-        if (force || val != config->screen.screen_rotation) {
-            config->screen.screen_rotation = val;
-            changed = cfg_screen_rotation;
-        }
+    return -1;
+}
 
-    }  // type of filenaming, with MAC adress or datetime
-    else if (!strcmp(var, config_items[cfg_ubx_file]) || !strcmp(var, "UBXfile")) {
-        if (!value || value->tag != JSON_STRING) {
-            goto err;
-        }
-        const char *val = value->data.string_;
-        if (force || strcmp(val, config->ubx_file)) {
-            size_t len = strlen(val);
-            memcpy(config->ubx_file, val, len);
-            config->ubx_file[len] = 0;
-            changed = cfg_ubx_file;
-        }
-    }  // your preferred filename
-    else if (!strcmp(var, config_items[cfg_sleep_info]) || !strcmp(var, "Sleep_info")) {
-        if (!value || value->tag != JSON_STRING) {
-            goto err;
-        }
-        const char *val = value->data.string_;
-        if (force || strcmp(val, config->sleep_info)) {
-            size_t len = strlen(val);
-            memcpy(config->sleep_info, val, len);
-            config->sleep_info[len] = 0;
-            changed = cfg_sleep_info;
-        }
-    }  // your preferred sleep text
-    else if (strstr(var, config_items[cfg_ssid])==var) {
-        if (!value || value->tag != JSON_STRING) {
-            goto err;
-        }
-        const char *val = value->data.string_;
-        uint8_t num = 0;
-        if (var[4] == 49) num = 1;
-        else if(var[4] == 50) num = 2;
-        else if(var[4] == 51) num = 3;
-        else if(var[4] == 52) num = 4;
-        if (force || strcmp(val, config->wifi_sta[num].ssid)) {
-            size_t len = strlen(val);
-            memcpy(config->wifi_sta[num].ssid, val, len);
-            config->wifi_sta[num].ssid[len] = 0;
-            if (var[4] == 49) changed = cfg_ssid1;
-            else if(var[4] == 50) changed = cfg_ssid2;
-            else if(var[4] == 51) changed = cfg_ssid3;
-            // else if(var[4] == 52) changed = cfg_ssid4;
-            else changed = cfg_ssid;
-        }
-    }  // your SSID
-    else if (strstr(var, config_items[cfg_password])==var) {
-        if (!value || value->tag != JSON_STRING) {
-            goto err;
-        }
-        const char *val = value->data.string_;
-        uint8_t num = 0;
-        if (var[8] == 49) num = 1;
-        else if(var[8] == 50) num = 2;
-        else if(var[8] == 51) num = 3;
-        else if(var[8] == 52) num = 4;
-        if (force || strcmp(val, config->wifi_sta[num].password)) {
-            size_t len = strlen(val);
-            memcpy(config->wifi_sta[num].password, val, len);
-            config->wifi_sta[num].password[len] = 0;
-            if (var[8] == 49) changed = cfg_password1;
-            else if(var[8] == 50) changed = cfg_password2;
-            else if(var[8] == 51) changed = cfg_password3;
-            // else if(var[8] == 52) changed = cfg_password4;
-            else changed = cfg_password;
-        }
-    }  // your password
-    else if (!strcmp(var, config_items[cfg_hostname])) {
-        if (!value || value->tag != JSON_STRING) {
-            goto err;
-        }
-        const char *val = value->data.string_;
-        if (force || strcmp(val, config->hostname)) {
-            size_t len = strlen(val);
-            memcpy(config->hostname, val, len);
-            config->hostname[len] = 0;
-            changed = cfg_hostname;
-        }
-    }  // your hostname
-    else {
-    err:
+static int config_set_item(logger_config_t *config, int item, const JsonNode *value, const char *var, uint8_t force) {
+    config_lock_items(__func__, 1ULL << item);
+    int changed = config_set_value(&config_fields[item], config, value, force);
+    config_unlock_items(1ULL << item);
+    if (changed < 0) {
         ESP_LOGW(TAG, "[%s] error: %s %d", __FUNCTION__, var ? var : "-", value ? value->tag : -1);
-        /* if(root) {
-            char * x = json_stringify(root, "\n");
-            printf("%s", x);
-            free(x);
-        } */
-        changed = -2;
+        return -2;
     }
-    if (config->config_changed_screen_cb && changed>=0)
-        config->config_changed_screen_cb(var);
-    return changed;
+    if (!changed)
+        return -1;
+    config_publish(config);
+    return item;
 }
 
 int config_set_var(logger_config_t *config, const char *json, const char *var) {
@@ -950,12 +578,25 @@ int config_set_var(logger_config_t *config, const char *json, const char *var) {
 int config_save_var(struct logger_config_s *config, const char *json, const char *var, uint8_t ublox_hw) {
     ILOG(TAG,"[%s]",__func__);
     IMEAS_START();
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
     int ret = config_set_var(config, json, var);
-    if (ret > 0) {
-        ret = config_save_json(config, ublox_hw);
+    if (ret >= 0) {
+        // single change goes to the journal, full save only when it is due for compaction
+        config_store_lock(__func__);
+        logger_config_t *copy = config_persist_capture(config);
+        int64_t start = config_metric_start();
+        if (config_store_field(copy, ret) == ESP_OK) {
+            config_store_sync();
+            config_metric_end(cfg_metric_save, start);
+            config_metric_save(cfg_save_web);
+            ret = ESP_OK;
+            config_persisted_set(copy);
+            config_mirror_mark(ublox_hw); // text copy follows on compaction or config_flush
+            config_save_event = LOGGER_CONFIG_EVENT_CONFIG_SAVE_DONE;
+        } else {
+            ret = config_save_full(copy, ublox_hw, cfg_save_web);
+        }
+        config_store_release();
     }
-    xSemaphoreGive(c_sem_lock);
     IMEAS_END(TAG, "[%s] took %llu us", __FUNCTION__);
     return ret;
 }
@@ -965,632 +606,617 @@ int config_save_var_b(logger_config_t *config, const char *json, uint8_t ublox_h
     return config_save_var(config, json, 0, ublox_hw);
 }
 
+/// caller holds the section locks of changed and publishes afterwards
+static void config_decode_commit(logger_config_t *config, const logger_config_t *tmp, uint64_t changed) {
+    // callback pointer and anything else outside the fields is kept from the live config
+    for (uint8_t i = 0; i < config_item_count; i++) {
+        if (!(changed & (1ULL << i)))
+            continue;
+        const config_field_t *f = &config_fields[i];
+        config_field_copy(f, config, tmp);
+    }
+}
+
+esp_err_t config_apply(logger_config_t *config, const logger_config_t *staged, config_change_mask_t items, uint8_t ublox_hw) {
+    if (!config || !staged)
+        return ESP_ERR_INVALID_ARG;
+    if (!items)
+        return ESP_OK;
+    int64_t start = config_metric_start();
+    config_lock_items(__func__, items);
+    config_decode_commit(config, staged, items);
+    config_unlock_items(items);
+    esp_err_t ret = config_publish(config);
+    config_notify();
+    config_save_later(config, ublox_hw);
+    config_metric_end(cfg_metric_set, start);
+    return ret;
+}
+
 esp_err_t config_decode(logger_config_t *config, const char *json) {
     ILOG(TAG,"[%s]",__func__);
-    int ret = ESP_OK;
-    JsonNode *root = config_parse(json);
-    if (!root) {
+    if (!json)
+        return ESP_FAIL;
+    _Static_assert(lengthof(config_items) <= 64, "config items do not fit in done mask");
+    // parse into a copy, config is only touched when the whole document is valid
+    logger_config_t tmp;
+    memcpy(&tmp, config, sizeof(tmp));
+    int64_t start = config_metric_start();
+    config_json_parser_t p;
+    size_t len = strlen(json);
+    config_json_parser_init(&p, &tmp, len + 1);
+    if (config_json_feed(&p, json, len) != ESP_OK || config_json_finish(&p) != ESP_OK) {
+        ESP_LOGE(TAG, "Bad json: %s", json);
         return ESP_FAIL;
     }
-#define SET_CONF(a, b) config_set(config, a, b, 0);
-    int changed;
-    //changed = SET_CONF(root, config_items[cfg_cal_bat]);
-    changed = SET_CONF(root, config_items[cfg_speed_unit]);
-    changed = SET_CONF(root, config_items[cfg_sample_rate]);
-    changed = SET_CONF(root, config_items[cfg_gnss]);
-    changed = SET_CONF(root, config_items[cfg_speed_field]);
-    changed = SET_CONF(root, config_items[cfg_speed_large_font]);
-    changed = SET_CONF(root, config_items[cfg_dynamic_model]);
-    changed = SET_CONF(root, config_items[cfg_bar_length]);
-    changed = SET_CONF(root, config_items[cfg_stat_screens]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "Stat_screens");
-    changed = SET_CONF(root, config_items[cfg_stat_screens_time]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "Stat_screens_time");
-    changed = SET_CONF(root, config_items[cfg_stat_speed]);
-    changed = SET_CONF(root, config_items[cfg_archive_days]);
-    changed = SET_CONF(root, config_items[cfg_gpio12_screens]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "GPIO12_screens");
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-    changed = SET_CONF(root, config_items[cfg_screen_move_offset]);
-#else
-    changed = SET_CONF(root, config_items[cfg_screen_brightness]);
-#endif
-    changed = SET_CONF(root, config_items[cfg_board_logo]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "board_Logo");
-    if (changed <= -2)
-        changed = SET_CONF(root, "Board_Logo");
-    changed = SET_CONF(root, config_items[cfg_sail_logo]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "sail_Logo");
-    if (changed <= -2)
-        changed = SET_CONF(root, "Sail_Logo");
-    changed = SET_CONF(root, config_items[cfg_log_txt]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logTXT");
-    changed = SET_CONF(root, config_items[cfg_log_ubx]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logUBX");
-    changed = SET_CONF(root, config_items[cfg_log_ubx_nav_sat]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logUBX_nav_sat");
-    changed = SET_CONF(root, config_items[cfg_log_sbp]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logSBP");
-    changed = SET_CONF(root, config_items[cfg_log_gpy]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logGPY");
-    changed = SET_CONF(root, config_items[cfg_log_gpx]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "logGPX");
-    changed = SET_CONF(root, config_items[cfg_file_date_time]);
-    changed = SET_CONF(root, config_items[cfg_screen_rotation]);
-    changed = SET_CONF(root, config_items[cfg_update_enabled]);
-    changed = SET_CONF(root, config_items[cfg_update_channel]);
-    changed = SET_CONF(root, config_items[cfg_timezone]);
-    changed = SET_CONF(root, config_items[cfg_ubx_file]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "UBXfile");
-    changed = SET_CONF(root, config_items[cfg_sleep_info]);
-    if (changed <= -2)
-        changed = SET_CONF(root, "Sleep_info");
-    for(uint8_t i=0,j=L_CONFIG_SSID_MAX; i<j; i++) {
-        char ssid[12]={0}, password[12]={0};
-        memcpy(&ssid[0], config_items[cfg_ssid], 4);
-        memcpy(&password[0], config_items[cfg_password], 8);
-        if(i>0) ssid[4] = password[8] = i+48;
-        SET_CONF(root, &ssid[0]);
-        SET_CONF(root, &password[0]);
+    config_lock_items(__func__, p.changed);
+    config_decode_commit(config, &tmp, p.changed);
+    config_unlock_items(p.changed);
+    esp_err_t ret = p.changed ? config_publish(config) : ESP_OK;
+    config_metric_end(cfg_metric_decode, start);
+    config_notify();
+    return ret;
+}
+
+/// stream file through the parser in small chunks, no heap copy of the document
+static esp_err_t config_decode_file(logger_config_t *config, const char *path) {
+    if (!path)
+        return ESP_FAIL;
+    FILE *fd = fopen(path, "r");
+    if (!fd)
+        return ESP_FAIL;
+    int64_t start = config_metric_start();
+    logger_config_t tmp;
+    memcpy(&tmp, config, sizeof(tmp));
+    config_json_parser_t p;
+    config_json_parser_init(&p, &tmp, CONFIG_LOGGER_CONFIG_JSON_MAX_SIZE);
+    char chunk[128];
+    size_t n;
+    esp_err_t ret = ESP_OK;
+    while ((n = fread(chunk, 1, sizeof(chunk), fd)) > 0) {
+        config_metric_bytes(n, 0);
+        if ((ret = config_json_feed(&p, chunk, n)) != ESP_OK)
+            break;
+    }
+    fclose(fd);
+    if (ret == ESP_OK)
+        ret = config_json_finish(&p);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "[%s] bad config in %s", __func__, path);
+        return ret;
+    }
+    config_decode_commit(config, &tmp, p.changed);
+    config_metric_end(cfg_metric_decode, start);
+    return ESP_OK;
+}
+
+/// crc32 of a whole file, ESP_ERR_NOT_FOUND when there is none
+static esp_err_t config_file_crc(const char *path, uint32_t *crc) {
+    FILE *fd = path ? fopen(path, "r") : 0;
+    if (!fd)
+        return ESP_ERR_NOT_FOUND;
+    uint8_t chunk[128];
+    size_t n;
+    *crc = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk), fd)) > 0)
+        *crc = esp_rom_crc32_le(*crc, chunk, n);
+    fclose(fd);
+    return ESP_OK;
+}
+
+/// config.txt is not the text the snapshot was written or imported with, so it was edited or replaced since;
+/// file times are not trusted, a logger without rtc writes 1970 and a pc edit can carry any time
+static int config_json_is_changed(uint32_t text_crc) {
+    uint32_t stored;
+    if (config_snapshot_text_crc(config_snapshot_path, &stored) != ESP_OK)
+        return 1;
+    if (stored == CFG_SNAPSHOT_TEXT_ANY)
+        return 0; // snapshot from before the text crc, the next save records it
+    return stored != text_crc;
+}
+
+/// full snapshot, starts a new journal on top of it
+static esp_err_t config_snapshot_commit(const logger_config_t *config, const char *backup) {
+    uint32_t crc = 0;
+    esp_err_t ret = config_snapshot_save(config, config_overrides(config), config_text_crc, config_snapshot_path, backup, &crc);
+    if (ret == ESP_OK)
+        config_journal_reset(config_journal_path, crc);
+    return ret;
+}
+
+static esp_err_t config_snapshot_restore(logger_config_t *config, const char *path) {
+    uint32_t crc = 0;
+    esp_err_t ret = config_snapshot_load(config, path, &crc);
+    if (ret == ESP_OK)
+        config_journal_replay(config, config_journal_path, crc);
+    return ret;
+}
+
+/// file store: text mirror, binary snapshot and journal in the port directory
+static esp_err_t config_file_load(logger_config_t *config) {
+    esp_err_t ret;
+    config_text_crc = 0;
+    uint8_t text = config_file_crc(config_file_path, &config_text_crc) == ESP_OK;
+    if ((!text || !config_json_is_changed(config_text_crc)) && (ret = config_snapshot_restore(config, config_snapshot_path)) == ESP_OK) {
+        ILOG(TAG,"[%s] from %s done",__func__, config_snapshot_path);
+        return ret;
+    }
+    if ((ret = config_decode_file(config, config_file_path)) == ESP_OK) {
+        ILOG(TAG,"[%s] from %s done",__func__, config_file_path);
+    } else if ((ret = config_decode_file(config, config_file_backup_path)) == ESP_OK) {
+        ILOG(TAG,"[%s] from %s done",__func__, config_file_backup_path);
+    } else if ((ret = config_snapshot_restore(config, config_snapshot_backup_path)) == ESP_OK) {
+        ILOG(TAG,"[%s] from %s done",__func__, config_snapshot_backup_path);
+        return ret;
+    } else {
+        return ret;
+    }
+    // text was imported, next boot takes the fast path, a config.txt that failed is not retried either
+    int64_t save_start = config_metric_start();
+    if (config_snapshot_commit(config, 0) == ESP_OK) {
+        config_metric_end(cfg_metric_save, save_start);
+        config_metric_save(cfg_save_decode);
     }
-    changed = SET_CONF(root, config_items[cfg_hostname]);
-    
-    if (root)
-        json_delete(root);
     return ret;
-#undef SET_CONF
 }
 
 esp_err_t config_load_json(logger_config_t *config) {
     ILOG(TAG,"[%s]",__func__);
     IMEAS_START();
+    int64_t start = config_metric_start();
     int ret = ESP_OK;
-    char *json = 0;
-    xSemaphoreTake(c_sem_lock, portMAX_DELAY);
-    if ((json = s_read_from_file(config_file_path, 0))) {
-        ILOG(TAG,"[%s] from %s done",__func__, config_file_path);
-    } else if ((json = s_read_from_file(config_file_backup_path, 0))) {
-        ILOG(TAG,"[%s] from %s done",__func__, config_file_backup_path);
-    } else {
+    // whole config is replaced, readers wait for the load instead of seeing half of it
+    config_store_lock(__func__);
+    config_lock(__func__);
+    config_defaults(config); // stores only hold the overrides
+    if ((ret = config_store->load(config)) != ESP_OK)
         ESP_LOGE(TAG, "configuration not found...");
-        goto done;
-    }
-    //printf("conf:%s\n", json);
-    ret = config_decode(config, json);
-done:
-    xSemaphoreGive(c_sem_lock);
-    if (json)
-        free(json);
-    esp_event_post(CONFIG_EVENT, LOGGER_CONFIG_EVENT_CONFIG_LOAD_DONE, config, sizeof(logger_config_t), portMAX_DELAY);
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+    config_profile_load(config, ret == ESP_OK);
+#endif
+    if (ret == ESP_OK)
+        config_persisted_set(config);
+    config_view_stage(config);
+    config_unlock();
+    config_store_unlock();
+    if (config_view_commit() != ESP_OK)
+        ESP_LOGW(TAG, "[%s] readers see the loaded config once a view is free", __func__);
+    config_notify();
+    config_post_event(LOGGER_CONFIG_EVENT_CONFIG_LOAD_DONE, config);
+    config_metric_end(cfg_metric_load, start);
     IMEAS_END(TAG, "[%s] took %llu us", __FUNCTION__);
     return ret;
 }
 
+#if defined(CONFIG_LOGGER_CONFIG_JSON_MIRROR)
+typedef struct config_text_out_s {
+    void *fd;
+    uint32_t crc;
+} config_text_out_t;
+
+static int config_port_sink(void *ctx, const char *buf, size_t len) {
+    config_text_out_t *out = ctx;
+#if (CONFIG_LOGGER_CONFIG_LOG_LEVEL <= 1)
+    printf("%.*s", (int)len, buf);
+#endif
+    out->crc = esp_rom_crc32_le(out->crc, (const uint8_t *)buf, len);
+    return config_port_put(out->fd, buf, len);
+}
+#endif
+
+static esp_err_t config_file_store(const logger_config_t *config, uint8_t ublox_hw) {
+#if defined(CONFIG_LOGGER_CONFIG_JSON_MIRROR)
+    // text copy first, so the snapshot is never older than the file a user may edit
+    config_port_rename(config_file_path, config_file_backup_path);
+    config_text_out_t out = { .fd = config_port_open(config_file_path) };
+    if (!out.fd)
+        return ESP_FAIL;
+    esp_err_t ret = config_json_stream(config, config_overrides(config), ublox_hw, config_port_sink, &out);
+    if (config_port_close(out.fd))
+        ret = ESP_FAIL;
+    if (ret)
+        return ret;
+    config_text_crc = out.crc; // the text that is now on the card, not imported on the next boot
+#endif
+    return config_snapshot_commit(config, config_snapshot_backup_path);
+}
+
+/// single item to the journal, ESP_ERR_INVALID_STATE when it is due for compaction
+static esp_err_t config_file_store_field(const logger_config_t *config, uint8_t item) {
+    return config_journal_append(config, config_journal_path, item);
+}
+
+const config_store_t config_store_file = {
+    .name = "file",
+    .load = config_file_load,
+    .store = config_file_store,
+    .store_field = config_file_store_field,
+};
+
+static esp_err_t config_save_full(logger_config_t *config, uint8_t ublox_hw, config_save_trigger_t trigger) {
+    ILOG(TAG,"[%s] %s",__func__, config_store->name);
+    int64_t start = config_metric_start();
+    int ret = config_store->store(config, ublox_hw);
+    if (ret == ESP_OK) {
+        config_persisted_set(config);
+        config_mirror_stale = 0;
+        config_store_ublox_hw = ublox_hw;
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+        config_profile_sync(); // compaction point for the profile file as well
+#endif
+        config_metric_end(cfg_metric_save, start);
+        config_metric_save(trigger);
+    }
+    config_save_event = !ret ? LOGGER_CONFIG_EVENT_CONFIG_SAVE_DONE : LOGGER_CONFIG_EVENT_CONFIG_SAVE_FAIL;
+    return ret;
+}
+
 esp_err_t config_save_json(logger_config_t *config, uint8_t ublox_hw) {
-    ILOG(TAG,"[%s]",__func__);
+    config_store_lock(__func__);
+    esp_err_t ret = config_save_full(config_persist_capture(config), ublox_hw, cfg_save_api);
+    config_store_release();
+    return ret;
+}
+
+/// a few changed items go to the journal, anything larger is a full save, caller holds the store lock
+static int config_save_changes(logger_config_t *config, config_change_mask_t changed, uint8_t ublox_hw, config_save_trigger_t trigger) {
+    if (__builtin_popcountll(changed) <= CFG_JOURNAL_BATCH_MAX) {
+        int64_t start = config_metric_start();
+        config_change_mask_t m = changed;
+        for (; m; m &= m - 1) {
+            if (config_store_field(config, __builtin_ctzll(m)) != ESP_OK)
+                break;
+        }
+        if (!m) {
+            config_store_sync();
+            config_metric_end(cfg_metric_save, start);
+            config_metric_save(trigger);
+            config_persisted_set(config);
+            config_mirror_mark(ublox_hw);
+            config_save_event = LOGGER_CONFIG_EVENT_CONFIG_SAVE_DONE;
+            return ESP_OK;
+        }
+    }
+    return config_save_full(config, ublox_hw, trigger);
+}
+
+/// pending change to the store, all also writes what otherwise waits for compaction:
+/// a config.txt behind the journal and the active profile file
+static int config_flush_pending(uint8_t all) {
     int ret = ESP_OK;
-    strbf_t sb;
-    strbf_init(&sb);
-    char *json = config_encode_json(config, &sb, ublox_hw);
-    if (!json_validate(json)) {
-        ESP_LOGE(TAG, "[%s] bad json: %s", __FUNCTION__ , json);
-        goto done;
+    if (!config_lock_ready())
+        return ret;
+    config_store_lock(__func__);
+    portENTER_CRITICAL(&config_save_mux);
+    logger_config_t *config = config_save_pending;
+    uint8_t ublox_hw = config_save_ublox_hw;
+    config_save_pending = 0;
+    portEXIT_CRITICAL(&config_save_mux);
+    if (config) {
+        logger_config_t *copy = config_persist_capture(config);
+        config_change_mask_t changed = config_persisted_valid ? config_diff(&config_persisted, copy) : ~0ULL;
+        if (!changed) {
+            DLOG(TAG, "[%s] nothing changed since last save", __func__);
+        } else {
+            ret = config_save_changes(copy, changed, ublox_hw, cfg_save_menu);
+        }
+    }
+#if defined(CONFIG_LOGGER_CONFIG_JSON_MIRROR)
+    if (all && ret == ESP_OK && config_mirror_stale && config_persisted_valid) {
+        // full save rewrites config.txt and compacts the journal it was behind
+        memcpy(&config_persist_copy, &config_persisted, sizeof(config_persist_copy));
+        ret = config_save_full(&config_persist_copy, config_store_ublox_hw, cfg_save_api);
     }
-#if (CONFIG_LOGGER_CONFIG_LOG_LEVEL <= 1)
-    printf("[%s] save json: %s", __FUNCTION__, json);
 #endif
-    s_rename_file_n(config_file_path, config_file_backup_path, 1);
-    ret = s_write(config_file_path, 0, sb.start, sb.cur - sb.start);
-done:
-    strbf_free(&sb);
-    esp_event_post(CONFIG_EVENT, !ret ? LOGGER_CONFIG_EVENT_CONFIG_SAVE_DONE : LOGGER_CONFIG_EVENT_CONFIG_SAVE_FAIL, config, sizeof(logger_config_t), portMAX_DELAY);
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+    if (all && ret == ESP_OK)
+        ret = config_profile_sync();
+#endif
+    config_store_release();
     return ret;
 }
 
-logger_config_t *config_fix_values(logger_config_t *config) {
-    ILOG(TAG,"[%s]",__func__);
-    // int Logo_choice=config->Logo_choice;//preserve value config->Logo_choice
-    // for config->txt update !!
-    /* if (config->cal_bat > 1)
-        config->cal_bat = 1.0; */
-    if (config->file_date_time == 0)
+int config_flush(void) {
+    return config_flush_pending(1);
+}
+
+esp_err_t config_persist_live(logger_config_t *config, config_save_trigger_t trigger) {
+    logger_config_t *copy = config_persist_capture(config);
+    config_change_mask_t changed = config_persisted_valid ? config_diff(&config_persisted, copy) : ~0ULL;
+    return changed ? config_save_changes(copy, changed, config_store_ublox_hw, trigger) : ESP_OK;
+}
+
+#if (CONFIG_LOGGER_CONFIG_SAVE_DELAY_MS > 0)
+static void config_save_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // every further change restarts the quiet window
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_LOGGER_CONFIG_SAVE_DELAY_MS)))
+            ;
+        config_flush_pending(0);
+    }
+}
+#endif
+
+void config_save_later(logger_config_t *config, uint8_t ublox_hw) {
+    portENTER_CRITICAL(&config_save_mux);
+    config_save_pending = config;
+    config_save_ublox_hw = ublox_hw;
+    portEXIT_CRITICAL(&config_save_mux);
+#if (CONFIG_LOGGER_CONFIG_SAVE_DELAY_MS > 0)
+    if (!config_save_task_handle && xTaskCreate(config_save_task, "config_save", CONFIG_LOGGER_CONFIG_SAVE_TASK_STACK, 0, tskIDLE_PRIORITY + 1, &config_save_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "[%s] no save task, saving now", __func__);
+        config_save_task_handle = 0;
+        config_flush_pending(0);
+        return;
+    }
+    xTaskNotifyGive(config_save_task_handle);
+#else
+    config_flush_pending(0);
+#endif
+}
+
+/// rules between items, returns the items that had to be adjusted
+static config_change_mask_t config_fix_rules(logger_config_t *config) {
+    config_change_mask_t fixed = 0;
+    if (config->file_date_time == 0 && !config->gps.log_txt) {
         config->gps.log_txt = 1;  // because txt file is needed for generating new file count !!
-    if (config->screen.stat_screens_time < 1)
+        fixed |= 1ULL << cfg_log_txt;
+    }
+    if (config->screen.stat_screens_time < 1) {
         config->screen.stat_screens_time = 1;
+        fixed |= 1ULL << cfg_stat_screens_time;
+    }
+    return fixed;
+}
+
+/// first item of mask outside its range, -1 when all are fine
+static int config_check_range(const logger_config_t *config, config_change_mask_t items) {
+    for (; items; items &= items - 1) {
+        int i = __builtin_ctzll(items);
+        const config_field_t *f = &config_fields[i];
+        if (f->type == CFG_T_STR)
+            continue;
+        if (f->type == CFG_T_FLOAT) {
+            float v = config_field_get_float(f, config);
+            if (!(v >= f->min && v <= f->max))
+                return i;
+        } else {
+            int32_t v = config_field_get_int(f, config);
+            if (v < f->min || v > f->max)
+                return i;
+        }
+    }
+    return -1;
+}
+
+int config_txn_check(const config_txn_t *txn, config_change_mask_t items) {
+    return config_check_range(&txn->staged, items);
+}
+
+logger_config_t *config_fix_values(logger_config_t *config) {
+    ILOG(TAG,"[%s]",__func__);
+    config_fix_rules(config);
     return config;
 }
 
+esp_err_t config_txn_begin(config_txn_t *txn, logger_config_t *config, uint8_t ublox_hw) {
+    if (!txn || !config)
+        return ESP_ERR_INVALID_ARG;
+    config_lock(__func__);
+    memcpy(&txn->staged, config, sizeof(txn->staged));
+    config_unlock();
+    txn->config = config;
+    txn->changed = 0;
+    txn->ublox_hw = ublox_hw;
+    return ESP_OK;
+}
+
+int config_txn_set(config_txn_t *txn, const char *name, const JsonNode *value) {
+    if (!txn || !txn->config || !name || !value)
+        return -2;
+    int item = config_item_lookup(name);
+    if (item < 0) {
+        ESP_LOGW(TAG, "[%s] unknown %s", __func__, name);
+        return -2;
+    }
+    const config_field_t *f = &config_fields[item];
+    if (value->tag == JSON_NUMBER && f->type != CFG_T_STR && !config_field_in_range(f, value->data.number_)) {
+        ESP_LOGW(TAG, "[%s] %s out of range", __func__, name);
+        return -2;
+    }
+    int changed = config_set_value(f, &txn->staged, value, 0);
+    if (changed < 0) {
+        ESP_LOGW(TAG, "[%s] error: %s %d", __func__, name, value->tag);
+        return -2;
+    }
+    if (!changed)
+        return -1;
+    txn->changed |= 1ULL << item;
+    return item;
+}
+
+int config_txn_set_json(config_txn_t *txn, const char *json) {
+    JsonNode *root = json ? config_parse(json) : 0, *node;
+    if (!root)
+        return -1;
+    int count = 0;
+    int64_t start = config_metric_start();
+    json_foreach(node, root) {
+        int ret = config_txn_set(txn, node->key, node);
+        if (ret == -2) {
+            count = -1;
+            break;
+        }
+        if (ret >= 0)
+            count++;
+    }
+    config_metric_end(cfg_metric_set, start);
+    json_delete(root);
+    return count;
+}
+
+esp_err_t config_txn_commit(config_txn_t *txn) {
+    if (!txn || !txn->config)
+        return ESP_ERR_INVALID_STATE;
+    logger_config_t *config = txn->config;
+    txn->config = 0;
+    if (!txn->changed)
+        return ESP_OK;
+    // checked as a whole, nothing reaches the live config when one item is off
+    config_change_mask_t items = txn->changed | config_fix_rules(&txn->staged);
+    int bad = config_check_range(&txn->staged, items);
+    if (bad >= 0) {
+        ESP_LOGW(TAG, "[%s] %s out of range", __func__, config_fields[bad].name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // saved from a copy first, the live config only sees the items once they are stored,
+    // the store lock keeps a flush from saving the old values in between
+    config_store_lock(__func__);
+    logger_config_t *copy = config_persist_capture(config);
+    config_decode_commit(copy, &txn->staged, items);
+    config_change_mask_t changed = config_persisted_valid ? config_diff(&config_persisted, copy) : ~0ULL;
+    esp_err_t ret = changed ? config_save_changes(copy, changed, txn->ublox_hw, cfg_save_api) : ESP_OK;
+    if (ret == ESP_OK) {
+        config_lock_items(__func__, items);
+        config_decode_commit(config, &txn->staged, items);
+        config_unlock_items(items);
+        ret = config_publish(config);
+    }
+    config_store_release();
+    config_notify();
+    return ret;
+}
+
+void config_txn_abort(config_txn_t *txn) {
+    if (txn) {
+        txn->config = 0;
+        txn->changed = 0;
+    }
+}
+
 int config_compare(logger_config_t *orig, logger_config_t *config) {
     ILOG(TAG,"[%s]",__func__);
     if (!orig || !config)
         return -1;
-    if (orig && !config)
-        return -2;
-    if (!orig && config)
-        return -3;
-    if(orig && config) {
-        if (orig->gps.speed_unit != config->gps.speed_unit)
-            return cfg_speed_unit;
-        if (orig->gps.sample_rate != config->gps.sample_rate)
-            return cfg_sample_rate;
-        if (orig->gps.gnss != config->gps.gnss)
-            return cfg_gnss;
-        if (orig->screen.speed_field != config->screen.speed_field)
-            return cfg_speed_field;
-        if (orig->screen.speed_large_font != config->screen.speed_large_font)
-            return cfg_speed_large_font;
-        if (orig->bar_length != config->bar_length)
-            return cfg_bar_length;
-        if (orig->screen.stat_speed != config->screen.stat_speed)
-            return cfg_stat_speed;
-        if (orig->archive_days != config->archive_days)
-            return cfg_archive_days;
-        if (orig->screen.stat_screens_time != config->screen.stat_screens_time)
-            return cfg_stat_screens_time;
-        if (orig->screen.stat_screens != config->screen.stat_screens)
-            return cfg_stat_screens;
-        // if (orig->screen.stat_screens_persist != config->screen.stat_screens_persist)
-        //     return 12;
-        if (orig->screen.gpio12_screens != config->screen.gpio12_screens)
-            return cfg_gpio12_screens;
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-        if (orig->screen_move_offset != config->screen_move_offset)
-            return cfg_screen_move_offset;
-#else
-        if (orig->screen_brightness != config->screen_brightness)
-            return cfg_screen_brightness;
-#endif
-        if (orig->screen.board_logo != config->screen.board_logo)
-            return cfg_board_logo;
-        if (orig->screen.sail_logo != config->screen.sail_logo)
-            return cfg_sail_logo;
-        if (orig->gps.log_txt != config->gps.log_txt)
-            return cfg_log_txt;
-        if (orig->gps.log_ubx != config->gps.log_ubx)
-            return cfg_log_ubx;
-        if (orig->gps.log_ubx_nav_sat != config->gps.log_ubx_nav_sat)
-            return cfg_log_ubx_nav_sat;
-        if (orig->gps.log_sbp != config->gps.log_sbp)
-            return cfg_log_sbp;
-        if (orig->gps.log_gpy != config->gps.log_gpy)
-            return cfg_log_gpy;
-        if (orig->file_date_time != config->file_date_time)
-            return cfg_file_date_time;
-        if (orig->gps.dynamic_model != config->gps.dynamic_model)
-            return cfg_dynamic_model;
-        if (orig->timezone != config->timezone)
-            return cfg_timezone;
-        if (strcmp(config->ubx_file, orig->ubx_file))
-            return cfg_ubx_file;
-        if (strcmp(config->sleep_info, orig->sleep_info))
-            return cfg_sleep_info;
-        if (strcmp(config->hostname, orig->hostname))
-            return cfg_hostname;
-        if (orig->speed_field_count != config->speed_field_count)
-            return cfg_hostname+1;
-        if (config->screen.screen_rotation != orig->screen.screen_rotation)
-            return cfg_screen_rotation;
-        if (config->fwupdate.update_enabled != orig->fwupdate.update_enabled)
-            return cfg_update_enabled;
-        if (config->fwupdate.channel != orig->fwupdate.channel)
-            return cfg_update_channel;
-        for(uint8_t i=0,j=L_CONFIG_SSID_MAX,k=cfg_ssid; i<j; i++,k+=2) {
-            if (strcmp(config->wifi_sta[i].ssid, orig->wifi_sta[i].ssid))
-                return k;
-            if (strcmp(config->wifi_sta[i].password, orig->wifi_sta[i].password))
-                return k+1;
-        }
-    }
+    config_change_mask_t changed = config_diff(orig, config);
+    if (changed)
+        return __builtin_ctzll(changed);
+    if (orig->speed_field_count != config->speed_field_count)
+        return config_item_count;
     return 0;
 }
 
-char *config_get(const logger_config_t *config, const char *name, char *str, size_t *len, size_t max, uint8_t mode, const uint8_t ublox_hw) {
-    ILOG(TAG, "[%s] %s", __FUNCTION__, name);
-    *len = 0;
-    if (!config) {
-        return 0;
-    }
-    // _ubx_hw_t ublox_hw = get_ublox_hw();
+static const char * const config_gnss_info_m9 = " default For M9 default 4 gnss: GPS(G) + GALILEO(E) + BEIDOU(B) + GLONASS(R)";
+static const char * const config_field_kinds[] = {
+    [CFG_T_UINT] = "int",
+    [CFG_T_INT] = "int",
+    [CFG_T_BOOL] = "bool",
+    [CFG_T_BITS] = "int",
+    [CFG_T_FLOAT] = "float",
+    [CFG_T_STR] = "str",
+};
 
-    if (!strstr(config_item_names, name) || (ublox_hw != UBX_TYPE_M8 && !strcmp(name, config_items[cfg_dynamic_model]))){
-        return 0;
+static void config_put_value(strbf_t *sb, const config_field_t *f, const logger_config_t *config) {
+    switch (f->type) {
+    case CFG_T_STR:
+        strbf_putc(sb, '"');
+        strbf_puts(sb, (const char *)CFG_FIELD_PTR(f, config));
+        strbf_putc(sb, '"');
+        break;
+    case CFG_T_FLOAT:
+        strbf_putd(sb, config_field_get_float(f, config), 1, f->prec);
+        break;
+    default:
+        strbf_putn(sb, config_field_get_int(f, config));
+        break;
     }
+}
 
-    strbf_t lsb;
-    if (str)
-        strbf_inits(&lsb, str, max);
-    else
-        strbf_init(&lsb);
+static void config_put_meta(strbf_t *sb, int item, const config_field_t *f, uint8_t ublox_hw) {
+    strbf_puts(sb, ",\"info\":\"");
+    strbf_puts(sb, (item == cfg_gnss && ublox_hw >= UBX_TYPE_M9) ? config_gnss_info_m9 : f->info);
+    strbf_puts(sb, "\",\"type\":\"");
+    strbf_puts(sb, config_field_kinds[f->type]);
+    strbf_putc(sb, '"');
+    if (f->ext) {
+        strbf_puts(sb, ",\"ext\":\"");
+        strbf_puts(sb, f->ext);
+        strbf_putc(sb, '"');
+    }
+    const config_field_list_t *l = f->values;
+    if (!l)
+        return;
+    strbf_puts(sb, f->type == CFG_T_BITS ? ",\"toggles\":[" : ",\"values\":[");
+    for (uint8_t i = 0, n = 0; i < l->count; i++) {
+        int16_t val = config_field_list_value(l, i);
+        if (item == cfg_gnss && ublox_hw < UBX_TYPE_M9 && val == 111)
+            continue;
+        if (n++)
+            strbf_putc(sb, ',');
+        if (f->type == CFG_T_BITS) {
+            strbf_puts(sb, "{\"pos\":");
+            strbf_putn(sb, i);
+            strbf_puts(sb, ",\"title\":\"");
+            strbf_puts(sb, l->titles[i]);
+            strbf_puts(sb, "\",\"value\":");
+            strbf_putn(sb, 1 << i);
+            strbf_putc(sb, '}');
+        } else {
+            strbf_puts(sb, "{\"value\":");
+            strbf_putn(sb, val);
+            strbf_puts(sb, ",\"title\":\"");
+            strbf_puts(sb, l->titles[i]);
+            strbf_puts(sb, "\"}");
+        }
+    }
+    strbf_putc(sb, ']');
+}
 
+static void config_put_item(strbf_t *sb, int item, const char *name, const logger_config_t *config, uint8_t mode, uint8_t ublox_hw) {
+    const config_field_t *f = &config_fields[item];
     if (mode) {
-        strbf_puts(&lsb, "{\"name\":");
+        strbf_puts(sb, "{\"name\":");
     }
 
-    strbf_puts(&lsb, "\"");
-    strbf_puts(&lsb, name);
-    strbf_puts(&lsb, "\"");
+    strbf_puts(sb, "\"");
+    strbf_puts(sb, name);
+    strbf_puts(sb, "\"");
 
     if (mode) {
-        strbf_puts(&lsb, ",\"value\"");
+        strbf_puts(sb, ",\"value\"");
     }
-    strbf_putc(&lsb, ':');
-#ifdef USE_CUSTOM_CALIBRATION_VAL
-    if (!strcmp(name, config_items[cfg_cal_bat])) {  // calibration for read out bat voltage
-        strbf_putd(&lsb, config->cal_bat, 1, 4);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"calibration for read out bat voltage\",\"type\":\"float\",\"ext\":\"V\"");
-        }
-    } else 
-#endif
-    if (!strcmp(name, config_items[cfg_speed_unit])) {  // speed units, 0 = m/s 1 = km/h, 2 = knots
-        strbf_putn(&lsb, config->gps.speed_unit);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"Speed display units\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j=(lengthof(speed_units)); i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, speed_units[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_sample_rate])) {  // gps_rate in Hz, 1, 5 or 10Hz !!!
-        strbf_putn(&lsb, config->gps.sample_rate);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"gps_rate in Hz\",\"type\":\"int\"");
-            strbf_puts(&lsb,",\"values\":[");
-            for(uint8_t i = 0, j = 5, k; i < j; i++) {
-                k = (i==3) ? (i)*5+1 : (i > 0) ? (i)*5 : 1;
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, k);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, sample_rates[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-            strbf_puts(&lsb, ",\"ext\":\"Hz\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_gnss])) {
-        strbf_putn(&lsb, config->gps.gnss);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\" default ");
-            if (ublox_hw >= UBX_TYPE_M9) {
-                strbf_puts(&lsb, "For M9 default 4 gnss: GPS(G) + GALILEO(E) + BEIDOU(B) + GLONASS(R)");
-            }
-            else {
-                strbf_puts(&lsb, "For M10 default 3 gnss: GPS(G) + GALILEO(B) + GLONASS(R)");
-            }
-            strbf_puts(&lsb, "\",\"type\":\"int\",\"values\":[");
-            strbf_puts(&lsb, "{\"value\":39,\"title\":\"GPS(G) + GALILEO(E)\"},");
-            strbf_puts(&lsb, "{\"value\":43,\"title\":\"GPS(G) + BEIDOU(B)\"},");
-            strbf_puts(&lsb, "{\"value\":99,\"title\":\"GPS(G) + GLONASS(R)\"},");
-            strbf_puts(&lsb, "{\"value\":47,\"title\":\"GPS(G) + GALILEO(E) + BEIDOU(B)\"},");
-            strbf_puts(&lsb, "{\"value\":103,\"title\":\"GPS(G) + GALILEO(E) + GLONASS(R)\"},");
-            strbf_puts(&lsb, "{\"value\":107,\"title\":\"GPS(G) + BEIDOU(B) + GLONASS(R) \"}");
-            if (ublox_hw >= UBX_TYPE_M9) {
-                strbf_puts(&lsb, ",{\"value\":111,\"title\":\"GPS(G) + GALILEO(E) + BEIDOU(B) + GLONASS(R)\"}");
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_speed_field])) {  // choice for first field in speed screen !!!
-        strbf_putn(&lsb, config->screen.speed_field);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"choice for first field in speed screen\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = config_speed_field_item_count; i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i+1);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, config_speed_field_items[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
+    strbf_putc(sb, ':');
+    config_put_value(sb, f, config);
+    if (mode) {
+        config_put_meta(sb, item, f, ublox_hw);
+        strbf_puts(sb, "}");
     }
+}
 
-    else if (!strcmp(name, config_items[cfg_speed_large_font])) {  // fonts on the first line are bigger, actual speed font is smaller
-        strbf_putn(&lsb, config->screen.speed_large_font);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"fonts on the first line are bigger, actual speed font is smaller\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_dynamic_model])) {  // choice for dynamic model "Sea",if 0 model "portable" is used !!
-        strbf_putn(&lsb, config->gps.dynamic_model);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"choice for dynamic model 'Sea', if 0 model 'Portable' is used !!\",\"type\":\"int\",");
-            strbf_puts(&lsb, "\"values\":[{\"value\":0,\"title\":\"Portable\"},");
-            strbf_puts(&lsb, "{\"value\":1,\"title\":\"Sea\"},");
-            strbf_puts(&lsb, "{\"value\":2,\"title\":\"Automotive\"}");
-            strbf_puts(&lsb, "]");
-        }
+static int config_get_item(const logger_config_t *config, const char *name, uint8_t ublox_hw) {
+    if (!config)
+        return -1;
+    int item = config_item_lookup(name);
+    if (item < 0 || ((config_fields[item].flags & CFG_F_UBX_M8) && ublox_hw != UBX_TYPE_M8))
+        return -1;
+    return item;
+}
 
-    } else if (!strcmp(name, config_items[cfg_timezone])) {  // choice for timedifference in hours with UTC, for Belgium 1 or 2 (summertime)
-        strbf_putd(&lsb, config->timezone, 1, 0);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"timezone: The local time difference in hours with UTC\",\"type\":\"float\",\"ext\":\"h\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(int8_t i = 0, j=4; i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, ",\"title\":\"GMT");
-                if (i > 0) strbf_putc(&lsb, '+');
-                else if (i < 0) strbf_putc(&lsb, '-');
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }                                        // 2575
-    } else if (!strcmp(name, config_items[cfg_stat_screens])||!strcmp(name, "Stat_screens")) {  // choice for stats field when no speed, here stat_screen
-        // 1, 2 and 3 will be active
-        strbf_putn(&lsb, config->screen.stat_screens);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"Stat_screens choice : activate / deactivate screens to show.\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"toggles\":[");
-            uint16_t j = 1;
-            for(uint8_t i= 0, k = config_stat_screen_item_count; i < k; i++, j <<= 1) {
-                strbf_puts(&lsb, "{\"pos\":");
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, config_stat_screen_items[i]);
-                strbf_puts(&lsb, "\",\"value\":");
-                strbf_putn(&lsb, j);
-                strbf_puts(&lsb, "}");
-                if(i < k-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_stat_screens_time])||!strcmp(name, "Stat_screens_time")) {  // time between switching stat_screens
-        strbf_putn(&lsb, config->screen.stat_screens_time);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"The time between toggle the different stat screens\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = 5; i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i+1);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_putn(&lsb, i+1);
-                strbf_puts(&lsb, " sec\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, "gpio12_screens")||!strcmp(name, "GPIO12_screens")) {  // choice for stats field when gpio12 is activated
-        // (pull-up high, low = active)
-        strbf_putn(&lsb, config->screen.gpio12_screens);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"GPIO12_screens choice : Every digit shows the according GPIO_screen after each push. Screen 4 = s10 runs, screen 5 = alfa's.\",\"type\":\"int\"");
-        }
-    // } else if (!strcmp(name, config_items[cfg_stat_screens_persist])) {  // choice for stats field when no speed, here
-    //     // stat_screen 1, 2 and 3 will be active / for
-    //     // resave the config
-    //     strbf_putn(&lsb, config->screen.stat_screens_persist);
-    //     if (mode) {
-    //         strbf_puts(&lsb, ",\"info\":\"Persist stat screens\",\"type\":\"int\"");
-    //     }
-    // } else if (!strcmp(name, "gpio12_screens_persist")) {  // choice for stats field when gpio12 is
-    //     // activated (pull-up high, low = active) / for
-    //     // resave the config
-    //     strbf_putn(&lsb, config->screen.gpio12_screens_persist);
-    //     if (mode) {
-    //         strbf_puts(&lsb, ",\"info\":\"choice for stats field when gpio12 is activated (pull-up high, low = active) / for resave the config\",\"type\":\"int\"");
-    //     }
-#if !defined(CONFIG_DISPLAY_DRIVER_ST7789)
-    } else if (!strcmp(name, config_items[cfg_screen_move_offset])) {
-        strbf_putn(&lsb, config->screen_move_offset);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"move epd sceen content to pervent panel burn\",\"type\":\"bool\"");
-        }
-#else
-    } else if (!strcmp(name, config_items[cfg_screen_brightness])) {
-        strbf_putn(&lsb, config->screen_brightness);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"Display brightness\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = 100, step = 20; i < j; i+=step) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i+step);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, i==0 ? "20" : i==20 ? "40" : i==40 ? "60" : i==60 ? "80" : "100");
-                strbf_puts(&lsb, "\"}");
-                if(i < j-step) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-#endif
-    } else if (!strcmp(name, config_items[cfg_board_logo])||!strcmp(name, "board_logo")||!strcmp(name, "Board_Logo")) {
-        strbf_putn(&lsb, config->screen.board_logo);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"Board_Logo\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = lengthof(board_logos); i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i+1);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, board_logos[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_sail_logo])||!strcmp(name, "sail_logo")||!strcmp(name, "Sail_Logo")) {
-        strbf_putn(&lsb, config->screen.sail_logo);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"Sail Logo\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = lengthof(sail_logos); i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i+1);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, sail_logos[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_stat_speed])) {  // max speed in m/s for showing Stat screens
-        strbf_putn(&lsb, config->screen.stat_speed);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"max speed in m/s for showing Stat screens\",\"type\":\"int\",\"ext\":\"m/s\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_bar_length])) {  // choice for bar indicator for length of run in m
-        // (nautical mile)
-        strbf_putn(&lsb, config->bar_length);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"bar_length: Default length = 1852 m for 100% bar (=Nautical mile)\",\"type\":\"int\",\"ext\":\"m\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_archive_days])) {  // how many days files will be moved to the "Archive" dir
-        strbf_putn(&lsb, config->archive_days);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"how many days files will be moved to the 'Archive' dir\",\"type\":\"int\",\"ext\":\"d\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_update_enabled])) {  // switchinf off .txt files
-        strbf_putn(&lsb, config->fwupdate.update_enabled);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"wether to allow automatic firmware updates or not\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_update_channel])) {  // switchinf off .txt files
-        strbf_putn(&lsb, config->fwupdate.channel);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"automatic firmware update channel\",\"type\":\"int\"");
-            strbf_puts(&lsb, ",\"values\":[");
-            for(uint8_t i = 0, j = lengthof(channels); i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, channels[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    } else if (!strcmp(name, config_items[cfg_log_txt])||!strcmp(name, "logTXT")) {  // switchinf off .txt files
-        strbf_putn(&lsb, config->gps.log_txt);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log to .txt\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_log_ubx])||!strcmp(name, "logUBX")) {  // log to .ubx
-        strbf_putn(&lsb, config->gps.log_ubx);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log to .ubx\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_log_ubx_nav_sat])||!strcmp(name, "logUBX_nav_sat")) {  // log nav sat msg to .ubx
-        strbf_putn(&lsb, config->gps.log_ubx_nav_sat);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log nav sat msg to .ubx\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_log_sbp])||!strcmp(name, "logSBP")) {  // log to .sbp
-        strbf_putn(&lsb, config->gps.log_sbp);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log to .sbp\",\"type\":\"bool\"");
-        }
-    } else if (!strcmp(name, config_items[cfg_log_gpy])||!strcmp(name, "logGPY")) {
-        strbf_putn(&lsb, config->gps.log_gpy);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log to .gpy\",\"type\":\"bool\"");
-        }
-    }  // log to .gps
-    else if (!strcmp(name, config_items[cfg_log_gpx])||!strcmp(name, "logGPX")) {
-        strbf_putn(&lsb, config->gps.log_gpx);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"log to .gpx\",\"type\":\"bool\"");
-        }
-    }  // log to .gpx
-    else if (!strcmp(name, config_items[cfg_file_date_time])) {
-        strbf_putn(&lsb, config->file_date_time);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"type of filenaming, with MAC adress or datetime\",\"type\":\"int\",");
-            strbf_puts(&lsb, "\"values\":[");
-            strbf_puts(&lsb, "{\"value\":1,\"title\":\"name_date_time\"},");
-            strbf_puts(&lsb, "{\"value\":0,\"title\":\"name_MAC_index\"},");
-            strbf_puts(&lsb, "{\"value\":2,\"title\":\"date_time_name\"}");
-            strbf_puts(&lsb, "]");
-        }
-    }  // type of filenaming, with MAC adress or datetime
-    else if (!strcmp(name, config_items[cfg_screen_rotation])) {
-        strbf_putn(&lsb, config->screen.screen_rotation);
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"screen rotation degrees\",\"type\":\"int\",");
-            strbf_puts(&lsb, "\"values\":[");
-            for(uint8_t i = 0, j = lengthof(screen_rotations); i < j; i++) {
-                strbf_puts(&lsb, "{\"value\":");
-                strbf_putn(&lsb, i);
-                strbf_puts(&lsb, ",\"title\":\"");
-                strbf_puts(&lsb, screen_rotations[i]);
-                strbf_puts(&lsb, "\"}");
-                if(i < j-1) strbf_putc(&lsb, ',');
-            }
-            strbf_puts(&lsb, "]");
-        }
-    }  // screen_rotation
-    else if (!strcmp(name, config_items[cfg_ubx_file])||!strcmp(name, "UBXfile")) {
-        strbf_puts(&lsb, "\"");
-        strbf_puts(&lsb, config->ubx_file);
-        strbf_puts(&lsb, "\"");
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"your preferred filename\",\"type\":\"str\"");
-        }
-    }  // your preferred filename
-    else if (!strcmp(name, config_items[cfg_sleep_info])||!strcmp(name, "Sleep_info")) {
-        strbf_puts(&lsb, "\"");
-        strbf_puts(&lsb, config->sleep_info);
-        strbf_puts(&lsb, "\"");
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"your preferred sleep text\",\"type\":\"str\"");
-        }
-    }  // your preferred sleep text
-    else if (strstr(name, config_items[cfg_ssid])==name) {
-        uint8_t num = 0;
-        if (name[4] == 49) num = 1;
-        else if(name[4] == 50) num = 2;
-        else if(name[4] == 51) num = 3;
-        else if(name[4] == 52) num = 4;
-        strbf_puts(&lsb, "\"");
-        strbf_puts(&lsb, config->wifi_sta[num].ssid);
-        strbf_puts(&lsb, "\"");
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"wifi ssid\",\"type\":\"str\"");
-        }
-    }  // your SSID
-    else if (strstr(name, config_items[cfg_password])==name) {
-        uint8_t num = 0;
-        if (name[8] == 49) num = 1;
-        else if(name[8] == 50) num = 2;
-        else if(name[8] == 51) num = 3;
-        else if(name[8] == 52) num = 4;
-        strbf_puts(&lsb, "\"");
-        strbf_puts(&lsb, config->wifi_sta[num].password);
-        strbf_puts(&lsb, "\"");
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"wifi network password\",\"type\":\"str\"");
-        }
-    }  // your password
-    else if (!strcmp(name, config_items[cfg_hostname])) {
-        strbf_puts(&lsb, "\"");
-        strbf_puts(&lsb, config->hostname);
-        strbf_puts(&lsb, "\"");
-        if (mode) {
-            strbf_puts(&lsb, ",\"info\":\"hostname: the hostname of the device for present itself in the network\",\"type\":\"str\"");
-        }
-    }  // your hostname
-    if (mode)
-        strbf_puts(&lsb, "}");
+char *config_get(const logger_config_t *config, const char *name, char *str, size_t *len, size_t max, uint8_t mode, const uint8_t ublox_hw) {
+    ILOG(TAG, "[%s] %s", __FUNCTION__, name);
+    *len = 0;
+    int item = config_get_item(config, name, ublox_hw);
+    if (item < 0) {
+        return 0;
+    }
+
+    strbf_t lsb;
+    if (str)
+        strbf_inits(&lsb, str, max);
+    else
+        strbf_init(&lsb);
+    config_put_item(&lsb, item, name, config, mode, ublox_hw);
     *len = lsb.cur - lsb.start;
     DLOG(TAG, "[%s] conf: %s size: %d\n", __FUNCTION__, strbf_finish(&lsb), *len);
     return strbf_finish(&lsb);
@@ -1598,46 +1224,61 @@ char *config_get(const logger_config_t *config, const char *name, char *str, siz
 
 char *config_get_json(logger_config_t *config, strbf_t *sb, const char *str, uint8_t ublox_hw) {
     ILOG(TAG,"[%s]",__func__);
-    size_t blen = 8 * BUFSIZ, len = 0;
-    char buf[blen], *p = 0;
+    int item;
+    if (str && (item = config_get_item(config, str, ublox_hw)) >= 0)
+        config_put_item(sb, item, str, config, 1, ublox_hw);
+    return strbf_finish(sb);
+}
 
-    if (str) {
-        p = config_get(config, str, buf, &len, blen, 1, ublox_hw);
-        if (len) strbf_puts(sb, p);
+/// metadata never changes, built on first use for each receiver class and kept
+static char * _Atomic config_schema[4];
+static size_t config_schema_len[4];
+
+const char *config_schema_json(uint8_t ublox_hw, size_t *len) {
+    uint8_t k = (ublox_hw == UBX_TYPE_M8) | (ublox_hw >= UBX_TYPE_M9) << 1;
+    char *schema = atomic_load(&config_schema[k]);
+    if (!schema) {
+        strbf_t sb;
+        strbf_init(&sb);
+        strbf_putc(&sb, '[');
+        for (size_t i = 0, n = 0; i < config_item_count; i++) {
+            const config_field_t *f = &config_fields[i];
+            if ((f->flags & CFG_F_UBX_M8) && ublox_hw != UBX_TYPE_M8)
+                continue;
+            if (n++)
+                strbf_putc(&sb, ',');
+            strbf_puts(&sb, "{\"name\":\"");
+            strbf_puts(&sb, f->name);
+            strbf_putc(&sb, '"');
+            config_put_meta(&sb, i, f, ublox_hw);
+            strbf_putc(&sb, '}');
+        }
+        strbf_putc(&sb, ']');
+        char *expected = 0;
+        config_schema_len[k] = sb.cur - sb.start;
+        schema = strbf_finish(&sb);
+        if (!atomic_compare_exchange_strong(&config_schema[k], &expected, schema)) {
+            strbf_free(&sb); // built concurrently, same content
+            schema = expected;
+        }
     }
+    if (len)
+        *len = config_schema_len[k];
+    return schema;
+}
 
-    return strbf_finish(sb);  // str size 6444
+static int config_strbf_sink(void *ctx, const char *buf, size_t len) {
+    strbf_put(ctx, buf, len);
+    return 0;
 }
 
-char *config_encode_json(logger_config_t *config, strbf_t *sb, uint8_t ublox_hw) {
+esp_err_t config_encode_stream(const logger_config_t *config, uint8_t ublox_hw, config_sink_t sink, void *ctx) {
     ILOG(TAG,"[%s]",__func__);
-    size_t blen = BUFSIZ / 3 * 2, len = 0;
-    char buf[blen], *p = 0;
-
-    strbf_puts(sb, "{\n");
-
-    for(int i = 0, j = config_item_count; i < j; i++) {
-        if( (i==cfg_password && config->wifi_sta[0].password[0] == 0)
-            || (i==cfg_password1 && config->wifi_sta[1].password[0] == 0)
-            || (i==cfg_password2 && config->wifi_sta[2].password[0] == 0)
-            || (i==cfg_password3 && config->wifi_sta[3].password[0] == 0)
-            || (i==cfg_ssid && config->wifi_sta[0].ssid[0] == 0)
-            || (i==cfg_ssid1 && config->wifi_sta[1].ssid[0] == 0)
-            || (i==cfg_ssid2 && config->wifi_sta[2].ssid[0] == 0)
-            || (i==cfg_ssid3 && config->wifi_sta[3].ssid[0] == 0)) {
-            continue;
-        }
-        p = config_get(config, config_items[i], buf, &len, blen, 0, ublox_hw);
-        if (len) {
-            strbf_puts(sb, p);
-            if(i < j-1) {
-                strbf_putc(sb, ',');
-            }
-            strbf_putc(sb, '\n');
-        }
-    }
-
-    strbf_puts(sb, "}\n");
+    return config_json_stream(config, ~0ULL, ublox_hw, sink, ctx);
+}
 
+char *config_encode_json(logger_config_t *config, strbf_t *sb, uint8_t ublox_hw) {
+    ILOG(TAG,"[%s]",__func__);
+    config_json_stream(config, ~0ULL, ublox_hw, config_strbf_sink, sb);
     return strbf_finish(sb);
 }
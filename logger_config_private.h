@@ -1,6 +1,12 @@
 #ifndef FF1FE37F_2A63_46BE_9691_8B160D95C4BC
 #define FF1FE37F_2A63_46BE_9691_8B160D95C4BC
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "logger_config.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,7 +81,87 @@ extern "C" {
 #define WMEAS_END(a, b, ...) ((void)0)
 #endif
 
+ESP_EVENT_DECLARE_BASE(CONFIG_EVENT);
+
+/// copy config for the next view, taken under the section locks so the copy is consistent
+void config_view_stage(const struct logger_config_s *config);
+
+/// publish the staged copy, never waits for a reader; ESP_ERR_NOT_FINISHED while every spare view is held,
+/// the copy stays staged and the publish is retried from a timer
+esp_err_t config_view_commit(void);
+
+/// stop the publish retry
+void config_view_deinit(void);
+
+/// collect changed items for subscribers, done by config_view_publish
+void config_notify_mark(config_change_mask_t changed);
+
+/// dispatch collected changes to subscribers, no-op while the caller holds a section lock
+void config_notify(void);
+
+#define CFG_LOCK_ENUM(l) cfg_lock_##l,
+typedef enum {
+    CFG_LOCK_SECTION_LIST(CFG_LOCK_ENUM)
+    cfg_lock_store, // persistence, taken before any section lock and never inside one
+    cfg_lock_count
+} config_lock_id_t;
+
+void config_lock_init(void);
+void config_lock_deinit(void);
+int config_lock_ready(void);
+
+/// take the section locks covering items in section order, waiting counts as lock_wait, op names the caller in the lock trace
+void config_lock_items(const char *op, config_change_mask_t items);
+void config_unlock_items(config_change_mask_t items);
+
+/// all sections, for whole config copies and loads
+void config_lock(const char *op);
+void config_unlock(void);
+
+/// persistence stage: persisted copy, pending save and the store, storage I/O runs under this one only
+void config_store_lock(const char *op);
+void config_store_unlock(void);
+
+/// the calling task holds any section lock
+int config_lock_held(void);
+
+#if defined(CONFIG_LOGGER_CONFIG_LOCK_TRACE)
+void config_trace_acquired(config_lock_id_t lock, const char *op, int64_t start);
+void config_trace_released(config_lock_id_t lock);
+#endif
+
+/// start time for config_metric_end
+#define config_metric_start() esp_timer_get_time()
+void config_metric_end(config_metric_t m, int64_t start);
+void config_metric_bytes(size_t read, size_t written);
+void config_metric_save(config_save_trigger_t trigger);
+/// 64-bit counter or timestamp to a json buffer
+void config_put_u64(struct strbf_s *sb, uint64_t v);
+
+/// unsaved changes of the live config to the store, caller holds the store lock
+esp_err_t config_persist_live(struct logger_config_s *config, config_save_trigger_t trigger);
+
+/// first of items outside its range in the staged copy, -1 when all are fine
+int config_txn_check(const config_txn_t *txn, config_change_mask_t items);
+
+/// give back the store lock, then post the save event a save under it left due
+void config_store_release(void);
+
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+void config_profile_init(const char *dir);
+
+/// preload stored profiles, the active one takes the profile items of a stored config or is applied to one that was not found
+void config_profile_load(struct logger_config_s *config, uint8_t stored);
+
+/// copy profile items of a just saved config into the active profile, its file follows with config_profile_sync
+void config_profile_track(const struct logger_config_s *config);
+
+/// write the active profile file when the store has edits it does not, caller holds the store lock
+esp_err_t config_profile_sync(void);
+#endif
 
+/// post a lifecycle event, never blocks unless the full struct compatibility events are enabled
+void config_post_event(int32_t id, const struct logger_config_s *config);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,360 @@
+/*
+ * Host benchmark of the config hot paths: latency distribution, allocations per call and a check against recorded baselines.
+ *
+ *   idf.py --preview set-target linux && idf.py build && ./build/config_bench.elf
+ *
+ * Config files in LOGGER_CONFIG_HOST_DIR are deleted first, so every run measures the same store. The baseline is
+ * ../baseline.txt, BENCH_BASELINE=<path> reads another one. A missing baseline or BENCH_UPDATE=1 records the
+ * run instead of comparing it. The list runs BENCH_ROUNDS times interleaved and each benchmark reports its pass with the lowest
+ * p50, a burst of load on the host then costs one pass and not the comparison. The first benchmark calibrates, the baseline
+ * p50s are scaled by how much faster or slower it runs than when the baseline was recorded. Exits 1 when a benchmark is slower
+ * at p50 than the tolerance or allocates more per call. Timings only compare on the machine that recorded them, record a
+ * baseline per host.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_event.h"
+#include "esp_timer.h"
+
+#include "logger_config.h"
+#include "strbf.h"
+#include "ubx.h"
+
+#define BENCH_SAMPLES 200
+#define BENCH_ROUNDS 5         // passes over the whole list, each benchmark keeps its fastest pass
+#define BENCH_TOLERANCE_PCT 25 // p50 slower than the baseline by more than this counts as a regression, BENCH_TOLERANCE overrides
+#define BENCH_NAME_MAX 24
+#define BENCH_MAX 24
+#define BENCH_HW UBX_TYPE_M10
+
+/*
+ * Allocation counters, the linker sends malloc, calloc and realloc through these wrappers.
+ * Only calls from the bench task count, the event loop and save tasks run on their own.
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static TaskHandle_t bench_task = 0;
+static uint32_t bench_allocs = 0;
+static uint64_t bench_alloc_bytes = 0;
+
+static inline void bench_count(size_t size) {
+    if (bench_task && xTaskGetCurrentTaskHandle() == bench_task) {
+        bench_allocs++;
+        bench_alloc_bytes += size;
+    }
+}
+
+void *__wrap_malloc(size_t size) {
+    bench_count(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    bench_count(n * size);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    bench_count(size);
+    return __real_realloc(ptr, size);
+}
+
+typedef struct bench_s {
+    const char *name;
+    void (*run)(uint32_t i); // i-th call, lets a bench alternate values so every call changes something
+    uint16_t batch;          // calls per sample, for calls shorter than the timer resolution
+} bench_t;
+
+typedef struct bench_result_s {
+    uint32_t calls;
+    uint32_t min_ns, p50_ns, p90_ns, p99_ns, max_ns;
+    float allocs;      // per call
+    float alloc_bytes; // per call
+} bench_result_t;
+
+typedef struct bench_base_s {
+    char name[BENCH_NAME_MAX];
+    uint32_t p50_ns, p99_ns;
+    float allocs;
+} bench_base_t;
+
+static logger_config_t *bench_config = 0;
+static logger_config_t bench_copy;
+static char *bench_doc[2] = {0}; // full documents differing in sample_rate
+static config_txn_t bench_txn;
+static size_t bench_sunk = 0;
+static volatile uint32_t bench_spun = 0;
+
+static const char * const bench_sample_rate[2] = { "{\"sample_rate\":5}", "{\"sample_rate\":10}" };
+
+/// fixed work that touches none of the config code, its time against the baseline's scales the comparison to the host's speed
+static void bench_calibrate(uint32_t i) {
+    uint32_t x = i | 1;
+    for (uint16_t k = 0; k < 256; k++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    bench_spun = x;
+}
+
+static void bench_lookup(uint32_t i) {
+    config_item_lookup(config_items[i % config_item_count]);
+}
+
+static void bench_get(uint32_t i) {
+    char buf[256];
+    size_t len;
+    config_get(bench_config, config_items[i % config_item_count], buf, &len, sizeof(buf), 1, BENCH_HW);
+}
+
+static void bench_schema(uint32_t i) {
+    config_schema_json(BENCH_HW, 0);
+}
+
+static void bench_encode_json(uint32_t i) {
+    strbf_t sb;
+    strbf_init(&sb);
+    config_encode_json(bench_config, &sb, BENCH_HW);
+    strbf_free(&sb);
+}
+
+static int bench_sink(void *ctx, const char *buf, size_t len) {
+    bench_sunk += len;
+    return 0;
+}
+
+static void bench_encode_stream(uint32_t i) {
+    config_encode_stream(bench_config, BENCH_HW, bench_sink, 0);
+}
+
+static void bench_decode(uint32_t i) {
+    config_decode(bench_config, bench_doc[i & 1]);
+}
+
+static void bench_diff(uint32_t i) {
+    config_diff(bench_config, &bench_copy);
+}
+
+static void bench_view(uint32_t i) {
+    config_view_release(config_view_acquire(0));
+}
+
+static void bench_set_var(uint32_t i) {
+    config_set_var(bench_config, bench_sample_rate[i & 1], "sample_rate");
+}
+
+static void bench_menu_step(uint32_t i) {
+    set_gps_cfg_item(bench_config, 3, BENCH_HW); // speed_unit, the save itself runs later in the save task
+}
+
+static void bench_txn_commit(uint32_t i) {
+    config_txn_begin(&bench_txn, bench_config, BENCH_HW);
+    config_txn_set_json(&bench_txn, bench_sample_rate[i & 1]);
+    config_txn_commit(&bench_txn);
+}
+
+static void bench_save_var(uint32_t i) {
+    config_save_var(bench_config, bench_sample_rate[i & 1], "sample_rate", BENCH_HW);
+}
+
+static void bench_save_json(uint32_t i) {
+    config_save_json(bench_config, BENCH_HW);
+}
+
+static void bench_load_json(uint32_t i) {
+    config_load_json(bench_config);
+}
+
+static const bench_t bench_list[] = {
+    { "calibrate", bench_calibrate, 100 },
+    { "item_lookup", bench_lookup, 1000 },
+    { "get", bench_get, 100 },
+    { "schema_json", bench_schema, 1000 },
+    { "encode_json", bench_encode_json, 50 },
+    { "encode_stream", bench_encode_stream, 50 },
+    { "decode", bench_decode, 20 },
+    { "diff", bench_diff, 1000 },
+    { "view", bench_view, 1000 },
+    { "set_var", bench_set_var, 50 },
+    { "menu_step", bench_menu_step, 50 },
+    { "txn_commit", bench_txn_commit, 10 },
+    { "save_var", bench_save_var, 10 },
+    { "save_json", bench_save_json, 1 },
+    { "load_json", bench_load_json, 10 },
+};
+_Static_assert(lengthof(bench_list) <= BENCH_MAX, "more benchmarks than baseline entries");
+
+static int bench_cmp(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_run(const bench_t *b, bench_result_t *r) {
+    static uint32_t ns[BENCH_SAMPLES];
+    uint32_t i = 0;
+    for (uint16_t k = 0; k < b->batch; k++) // caches and lazily built tables
+        b->run(i++);
+    bench_allocs = 0;
+    bench_alloc_bytes = 0;
+    for (uint32_t s = 0; s < BENCH_SAMPLES; s++) {
+        int64_t start = esp_timer_get_time();
+        for (uint16_t k = 0; k < b->batch; k++)
+            b->run(i++);
+        ns[s] = (uint32_t)((esp_timer_get_time() - start) * 1000 / b->batch);
+    }
+    r->calls = BENCH_SAMPLES * b->batch;
+    r->allocs = (float)bench_allocs / r->calls;
+    r->alloc_bytes = (float)bench_alloc_bytes / r->calls;
+    qsort(ns, BENCH_SAMPLES, sizeof(ns[0]), bench_cmp);
+    r->min_ns = ns[0];
+    r->p50_ns = ns[BENCH_SAMPLES * 50 / 100];
+    r->p90_ns = ns[BENCH_SAMPLES * 90 / 100];
+    r->p99_ns = ns[BENCH_SAMPLES * 99 / 100];
+    r->max_ns = ns[BENCH_SAMPLES - 1];
+}
+
+/// one line per benchmark: name p50_ns p99_ns allocs_per_call, # starts a comment
+static int bench_baseline_load(const char *path, bench_base_t *base, int max) {
+    FILE *fd = fopen(path, "r");
+    if (!fd)
+        return -1;
+    char line[128];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), fd)) {
+        if (line[0] == '#')
+            continue;
+        bench_base_t *e = &base[n];
+        if (sscanf(line, "%23s %u %u %f", e->name, &e->p50_ns, &e->p99_ns, &e->allocs) == 4)
+            n++;
+    }
+    fclose(fd);
+    return n;
+}
+
+static int bench_baseline_save(const char *path, const bench_result_t *res, size_t count) {
+    FILE *fd = fopen(path, "w");
+    if (!fd)
+        return -1;
+    fprintf(fd, "# config_bench baseline, %d samples per benchmark, best of %d rounds\n# timings hold for the host that recorded them, BENCH_UPDATE=1 records this one\n"
+                "# name p50_ns p99_ns allocs_per_call\n", BENCH_SAMPLES, BENCH_ROUNDS);
+    for (size_t i = 0; i < count; i++)
+        fprintf(fd, "%s %u %u %.2f\n", bench_list[i].name, res[i].p50_ns, res[i].p99_ns, res[i].allocs);
+    return fclose(fd) ? -1 : 0;
+}
+
+static const bench_base_t *bench_baseline_find(const bench_base_t *base, int n, const char *name) {
+    for (int i = 0; i < n; i++) {
+        if (!strcmp(base[i].name, name))
+            return &base[i];
+    }
+    return 0;
+}
+
+/// files of earlier runs change what load and save do, every run starts from the built-in defaults
+static void bench_clean(void) {
+    const char *dir = CONFIG_LOGGER_CONFIG_HOST_DIR;
+    static const char * const prefix[] = { "config.", "profile", "kv_", "default.json" };
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+    for (struct dirent *e; (e = readdir(d));) {
+        for (size_t i = 0; i < lengthof(prefix); i++) {
+            if (!strncmp(e->d_name, prefix[i], strlen(prefix[i]))) {
+                char path[sizeof(CONFIG_LOGGER_CONFIG_HOST_DIR) + sizeof(e->d_name) + 1];
+                snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+                unlink(path);
+                break;
+            }
+        }
+    }
+    closedir(d);
+}
+
+static void bench_setup(void) {
+    mkdir(CONFIG_LOGGER_CONFIG_HOST_DIR, 0755);
+    bench_clean();
+    esp_event_loop_create_default(); // lifecycle events are posted like on the device
+    bench_config = config_new();
+    if (!bench_config) {
+        printf("config_init failed\n");
+        exit(2);
+    }
+    config_load_json(bench_config); // nothing stored yet
+    config_save_json(bench_config, BENCH_HW);
+    for (uint8_t i = 0; i < 2; i++) {
+        strbf_t sb;
+        strbf_init(&sb);
+        config_set_var(bench_config, bench_sample_rate[i], "sample_rate");
+        bench_doc[i] = strdup(config_encode_json(bench_config, &sb, BENCH_HW));
+        strbf_free(&sb);
+    }
+    config_clone(bench_config, &bench_copy);
+    bench_copy.gps.sample_rate = bench_copy.gps.sample_rate == 5 ? 10 : 5; // one item apart
+}
+
+void app_main(void) {
+    const char *path = getenv("BENCH_BASELINE") ? getenv("BENCH_BASELINE") : BENCH_BASELINE_PATH;
+    uint8_t update = getenv("BENCH_UPDATE") != 0;
+    int tolerance = getenv("BENCH_TOLERANCE") ? atoi(getenv("BENCH_TOLERANCE")) : BENCH_TOLERANCE_PCT;
+    static bench_result_t res[lengthof(bench_list)];
+    static bench_base_t base[BENCH_MAX];
+    int bases = bench_baseline_load(path, base, BENCH_MAX);
+    if (bases < 0)
+        update = 1; // first run records the baseline
+    bench_setup();
+    bench_task = xTaskGetCurrentTaskHandle();
+    for (uint8_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < lengthof(bench_list); i++) {
+            bench_result_t r;
+            bench_run(&bench_list[i], &r);
+            if (!round || r.p50_ns < res[i].p50_ns)
+                res[i] = r;
+        }
+    }
+    bench_task = 0;
+    printf("%-14s %8s %9s %9s %9s %9s %9s %8s %9s %9s %7s\n", "benchmark", "calls", "min_ns", "p50_ns", "p90_ns", "p99_ns", "max_ns",
+           "allocs", "bytes", "expect", "delta");
+    const bench_base_t *cal = update ? 0 : bench_baseline_find(base, bases, bench_list[0].name);
+    int64_t scale_now = cal && cal->p50_ns ? res[0].p50_ns : 1, scale_base = cal && cal->p50_ns ? cal->p50_ns : 1;
+    int regressions = 0;
+    for (size_t i = 0; i < lengthof(bench_list); i++) {
+        const bench_t *b = &bench_list[i];
+        const bench_result_t *r = &res[i];
+        printf("%-14s %8u %9u %9u %9u %9u %9u %8.2f %9.1f", b->name, r->calls, r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->max_ns,
+               r->allocs, r->alloc_bytes);
+        const bench_base_t *e = update ? 0 : bench_baseline_find(base, bases, b->name);
+        if (!e) {
+            printf(" %9s %7s\n", "-", "-");
+            continue;
+        }
+        int64_t expect = (int64_t)e->p50_ns * scale_now / scale_base;
+        int delta = expect ? (int)(((int64_t)r->p50_ns - expect) * 100 / expect) : 0;
+        // a sample is timed in whole microseconds, per call that is 1000 / batch ns, steps of it are not a change
+        uint8_t slow = delta > tolerance && r->p50_ns > expect + 2000 / b->batch, more = r->allocs > e->allocs + 0.005f;
+        printf(" %9u %+6d%%%s%s\n", (uint32_t)expect, delta, slow ? " SLOWER" : "", more ? " MORE ALLOCS" : "");
+        regressions += slow || more;
+    }
+    config_deinit(bench_config);
+    config_delete(bench_config);
+    if (update) {
+        if (bench_baseline_save(path, res, lengthof(bench_list)))
+            printf("cannot write baseline %s\n", path);
+        else
+            printf("baseline recorded in %s\n", path);
+    } else {
+        printf("%d of %u benchmarks regressed against %s by more than %d%%\n", regressions, (unsigned)lengthof(bench_list), path, tolerance);
+    }
+    fflush(stdout);
+    exit(regressions ? 1 : 0);
+}
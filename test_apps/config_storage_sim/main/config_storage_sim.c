@@ -0,0 +1,194 @@
+/*
+ * Storage stall report: runs the config save paths under simulated card profiles and reports, per profile and scenario, how
+ * long the calling task was blocked, how long storage kept the config locks held and the worst wait of a menu task for its
+ * section lock meanwhile. Readers of views take no lock and are never stalled by storage, the menu task is what freezes.
+ *
+ *   idf.py --preview set-target linux && idf.py build && ./build/config_storage_sim.elf
+ *
+ * The profiles are rough card classes, adjust them to the card behaviour to size against. Simulated delays are whole
+ * ticks, sdkconfig.defaults sets a 1 ms tick so the short ones keep their size.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_event.h"
+#include "esp_timer.h"
+
+#include "logger_config.h"
+#include "logger_config_private.h"
+#include "ubx.h"
+
+#define SIM_HW UBX_TYPE_M10
+#define SIM_MENU_STEPS 20
+#define SIM_WEB_EDITS 10
+#define SIM_FULL_SAVES 5
+#define SIM_PROFILE_SWITCHES 4
+
+typedef struct sim_card_s {
+    const char *name;
+    config_storage_profile_t profile;
+} sim_card_t;
+
+static const sim_card_t sim_cards[] = {
+    { "none", { 0 } },
+    { "fast", { .open_us = 1000, .write_us = 500, .fsync_us = 2000, .rename_us = 1000, .jitter_us = 500, .bytes_per_ms = 2000 } },
+    { "typical", { .open_us = 3000, .write_us = 2000, .fsync_us = 10000, .rename_us = 5000, .jitter_us = 5000, .bytes_per_ms = 500 } },
+    { "slow", { .open_us = 20000, .write_us = 10000, .fsync_us = 80000, .rename_us = 40000, .jitter_us = 50000, .bytes_per_ms = 100 } },
+};
+
+typedef struct sim_caller_s {
+    uint32_t calls;
+    uint64_t total_us;
+    uint32_t max_us;
+} sim_caller_t;
+
+static logger_config_t *sim_config = 0;
+static volatile uint8_t sim_menu_on = 0;
+static volatile uint32_t sim_menu_wait_max_us = 0;
+static TaskHandle_t sim_menu_task = 0;
+
+/// takes the screen section every tick like a menu step does, its worst wait is what a user sees as a frozen menu
+static void sim_menu_waiter(void *arg) {
+    for (;;) {
+        if (sim_menu_on) {
+            int64_t start = esp_timer_get_time();
+            config_lock_items(__func__, CFG_SCREEN_ITEMS_MASK);
+            uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+            config_unlock_items(CFG_SCREEN_ITEMS_MASK);
+            if (us > sim_menu_wait_max_us)
+                sim_menu_wait_max_us = us;
+        }
+        vTaskDelay(1);
+    }
+}
+
+static inline void sim_call_end(sim_caller_t *c, int64_t start) {
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    c->calls++;
+    c->total_us += us;
+    if (us > c->max_us)
+        c->max_us = us;
+}
+
+static void sim_menu(sim_caller_t *c) {
+    for (uint8_t i = 0; i < SIM_MENU_STEPS; i++) {
+        int64_t start = esp_timer_get_time();
+        set_gps_cfg_item(sim_config, 3, SIM_HW); // speed_unit, the save is left to the flush scenario
+        sim_call_end(c, start);
+    }
+}
+
+static void sim_flush(sim_caller_t *c) {
+    int64_t start = esp_timer_get_time();
+    config_flush();
+    sim_call_end(c, start);
+}
+
+static void sim_web(sim_caller_t *c) {
+    static const char * const rate[2] = { "{\"sample_rate\":5}", "{\"sample_rate\":10}" };
+    for (uint8_t i = 0; i < SIM_WEB_EDITS; i++) {
+        int64_t start = esp_timer_get_time();
+        config_save_var(sim_config, rate[i & 1], "sample_rate", SIM_HW);
+        sim_call_end(c, start);
+    }
+}
+
+static void sim_save(sim_caller_t *c) {
+    for (uint8_t i = 0; i < SIM_FULL_SAVES; i++) {
+        int64_t start = esp_timer_get_time();
+        config_save_json(sim_config, SIM_HW);
+        sim_call_end(c, start);
+    }
+}
+
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+static void sim_profile(sim_caller_t *c) {
+    int idx[2];
+    idx[0] = config_profile_save(sim_config, "sim_a");
+    set_gps_cfg_item(sim_config, 3, SIM_HW);
+    idx[1] = config_profile_save(sim_config, "sim_b");
+    if (idx[0] < 0 || idx[1] < 0)
+        return;
+    for (uint8_t i = 0; i < SIM_PROFILE_SWITCHES; i++) {
+        int64_t start = esp_timer_get_time();
+        config_profile_select(sim_config, idx[i & 1]);
+        sim_call_end(c, start);
+    }
+}
+#endif
+
+typedef struct sim_scenario_s {
+    const char *name;
+    void (*run)(sim_caller_t *c);
+} sim_scenario_t;
+
+static const sim_scenario_t sim_scenarios[] = {
+    { "menu_step", sim_menu },
+    { "flush", sim_flush },
+    { "web_edit", sim_web },
+    { "save_json", sim_save },
+#if (CONFIG_LOGGER_CONFIG_PROFILES_MAX > 0)
+    { "profile", sim_profile },
+#endif
+};
+
+static uint32_t sim_hold_max(const config_metrics_t *m, uint8_t store) {
+    if (store)
+        return m->timing[cfg_metric_hold_store].max_us;
+    uint32_t max = 0;
+    for (uint8_t i = cfg_metric_hold_gps; i < cfg_metric_hold_store; i++) {
+        if (m->timing[i].max_us > max)
+            max = m->timing[i].max_us;
+    }
+    return max;
+}
+
+static void sim_report(const sim_card_t *card, const sim_scenario_t *s) {
+    sim_caller_t c = {0};
+    config_storage_stats_t io;
+    config_metrics_t m;
+    config_storage_stats(0, 1);
+    config_metrics_get(0, 1);
+    sim_menu_wait_max_us = 0;
+    sim_menu_on = 1;
+    s->run(&c);
+    sim_menu_on = 0;
+    config_storage_stats(&io, 0);
+    config_metrics_get(&m, 0);
+    printf("%-8s %-10s %5u %10u %10u %5u %10u %10u %10u %10u %10u %10u %10u\n", card->name, s->name, c.calls,
+           c.calls ? (uint32_t)(c.total_us / c.calls) : 0, c.max_us, io.ops, (uint32_t)io.io_us, io.io_max_us, (uint32_t)io.locked_us,
+           io.locked_max_us, sim_hold_max(&m, 0), sim_hold_max(&m, 1), sim_menu_wait_max_us);
+}
+
+void app_main(void) {
+    mkdir(CONFIG_LOGGER_CONFIG_HOST_DIR, 0755);
+    esp_event_loop_create_default();
+    sim_config = config_new();
+    if (!sim_config) {
+        printf("config_init failed\n");
+        exit(2);
+    }
+    config_load_json(sim_config);
+    config_save_json(sim_config, SIM_HW);
+    xTaskCreate(sim_menu_waiter, "sim_menu", 4096, 0, 5, &sim_menu_task);
+    printf("%-8s %-10s %5s %10s %10s %5s %10s %10s %10s %10s %10s %10s %10s\n", "card", "scenario", "calls", "caller_avg", "caller_max",
+           "ops", "io_us", "io_max", "locked_us", "locked_max", "hold_sect", "hold_store", "menu_wait");
+    for (size_t i = 0; i < lengthof(sim_cards); i++) {
+        config_storage_sim_set(&sim_cards[i].profile);
+        for (size_t k = 0; k < lengthof(sim_scenarios); k++)
+            sim_report(&sim_cards[i], &sim_scenarios[k]);
+    }
+    config_storage_sim_set(0);
+    printf("times in us: caller_* per call of the scenario, io_* storage time of all tasks, locked_* the part of it under a config\n"
+           "section lock, hold_* the longest section and store lock hold, menu_wait the worst screen section wait of a menu task\n");
+    vTaskDelete(sim_menu_task);
+    config_deinit(sim_config);
+    config_delete(sim_config);
+    fflush(stdout);
+    exit(0);
+}